@@ -1,6 +1,21 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <vector>
+#include <memory>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
@@ -34,6 +49,222 @@ uint32_t total_tcp_packet_sent = 0;
 uint32_t total_tcp_packet_received = 0;
 uint64_t total_received_bytes = 0;
 
+/*
+ * Binary trace of a Time trace source. Each change is a fixed-size record
+ * appended to an in-memory block; the block is written with a single
+ * fwrite once full, and on Close(). The simulator runs every callback on
+ * its one thread, so the buffer needs no locking. ConvertTrace() turns a
+ * file back into the text format of RttTracer/RtoTracer. A per-flow sink
+ * is shared by all flows, and tags each record with the flow index.
+ */
+class BinaryTraceSink
+{
+public:
+  struct Record {
+    int64_t time;    // ns
+    int64_t oldval;  // ns
+    int64_t newval;  // ns
+    uint32_t flow;
+    uint32_t reserved;
+  };
+
+  static constexpr size_t kRecordsPerBlock = 8192;
+  static constexpr char kMagic[8] = {'R', 'T', 'O', 'T', 'R', 'C', '1', '\0'};
+  static constexpr char kFlowMagic[8] = {'R', 'T', 'O', 'T', 'R', 'C', 'F', '\0'};
+
+  explicit BinaryTraceSink(const std::string& fileName, bool perFlow = false)
+  {
+    m_file = std::fopen(fileName.c_str(), "wb");
+    NS_ABORT_MSG_IF(m_file == nullptr, "Cannot open " << fileName << ": " << std::strerror(errno));
+    std::fwrite(perFlow ? kFlowMagic : kMagic, sizeof(kMagic), 1, m_file);
+    m_buffer.reserve(kRecordsPerBlock);
+  }
+
+  ~BinaryTraceSink()
+  {
+    Close();
+  }
+
+  void Add(Time oldval, Time newval, uint32_t flow = 0)
+  {
+    m_buffer.push_back({Simulator::Now().GetNanoSeconds(), oldval.GetNanoSeconds(), newval.GetNanoSeconds(), flow, 0});
+    if (m_buffer.size() == kRecordsPerBlock)
+    {
+      Flush();
+    }
+  }
+
+  void Flush()
+  {
+    if (m_file != nullptr && !m_buffer.empty())
+    {
+      std::fwrite(m_buffer.data(), sizeof(Record), m_buffer.size(), m_file);
+      m_buffer.clear();
+    }
+  }
+
+  void Close()
+  {
+    Flush();
+    if (m_file != nullptr)
+    {
+      std::fclose(m_file);
+      m_file = nullptr;
+    }
+  }
+
+private:
+  FILE* m_file;
+  std::vector<Record> m_buffer;
+};
+
+constexpr char BinaryTraceSink::kMagic[8];
+constexpr char BinaryTraceSink::kFlowMagic[8];
+
+static std::unique_ptr<BinaryTraceSink> rttSink;
+static std::unique_ptr<BinaryTraceSink> rtoSink;
+
+/*
+ * Streaming histogram of positive values, with kBinsPerOctave bins per
+ * doubling between 2^kMinExp and 2^kMaxExp; values outside are counted
+ * in the first or last bin. Quantiles are exact to within one bin, about
+ * 4.4 % of the value, whatever the number of samples.
+ */
+class LogHistogram
+{
+public:
+  static constexpr int kBinsPerOctave = 16;
+  static constexpr int kMinExp = -4;
+  static constexpr int kMaxExp = 12;
+  static constexpr int kBins = (kMaxExp - kMinExp) * kBinsPerOctave;
+
+  void Add(double value)
+  {
+    int bin = 0;
+    if (value > 0)
+    {
+      bin = static_cast<int>(std::floor((std::log2(value) - kMinExp) * kBinsPerOctave));
+    }
+    m_bins[std::min(std::max(bin, 0), kBins - 1)]++;
+    m_count++;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+  }
+
+  // Lower edge of the bin holding the q-quantile, within [min, max]
+  double Quantile(double q) const
+  {
+    if (m_count == 0)
+    {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * m_count));
+    uint64_t seen = 0;
+    for (int i = 0; i < kBins; i++)
+    {
+      seen += m_bins[i];
+      if (seen >= rank && m_bins[i] > 0)
+      {
+        double edge = std::exp2(kMinExp + static_cast<double>(i) / kBinsPerOctave);
+        return std::min(std::max(edge, m_min), m_max);
+      }
+    }
+    return m_max;
+  }
+
+  uint64_t Count() const
+  {
+    return m_count;
+  }
+
+  double Min() const
+  {
+    return m_count ? m_min : 0;
+  }
+
+  double Max() const
+  {
+    return m_count ? m_max : 0;
+  }
+
+private:
+  std::array<uint32_t, kBins> m_bins{};
+  uint64_t m_count = 0;
+  double m_min = std::numeric_limits<double>::max();
+  double m_max = 0;
+};
+
+// Per-flow state of the per-flow tracing
+struct FlowStats {
+  bool firstRtt = true;
+  bool firstRto = true;
+  Time rto;                   // last RTO of the flow
+  uint32_t loss_entries = 0;  // entries in CA_LOSS, not counting RTOs already in it
+  uint32_t spurious = 0;      // RTOs undone as spurious
+  LogHistogram ratio;         // RTO in force / RTT, one value per RttSample
+};
+
+static std::vector<FlowStats> flowStats;
+static std::unique_ptr<BinaryTraceSink> flowRttSink;
+static std::unique_ptr<BinaryTraceSink> flowRtoSink;
+static Ptr<OutputStreamWrapper> flowRttStream;
+static Ptr<OutputStreamWrapper> flowRtoStream;
+
+// Write a binary trace as "time value" lines, the first line being the
+// initial value at time 0, as RttTracer and RtoTracer do. Lines of a
+// per-flow trace start with the flow index, with one initial line per flow
+static int
+ConvertTrace(const std::string& binFileName, const std::string& textFileName)
+{
+  FILE* in = std::fopen(binFileName.c_str(), "rb");
+  if (in == nullptr)
+  {
+    std::cerr << "Cannot open " << binFileName << ": " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  char magic[sizeof(BinaryTraceSink::kMagic)];
+  bool ok = std::fread(magic, sizeof(magic), 1, in) == 1;
+  bool per_flow = ok && std::memcmp(magic, BinaryTraceSink::kFlowMagic, sizeof(magic)) == 0;
+  if (!ok || (!per_flow && std::memcmp(magic, BinaryTraceSink::kMagic, sizeof(magic)) != 0))
+  {
+    std::cerr << binFileName << " is not a binary trace" << std::endl;
+    std::fclose(in);
+    return 1;
+  }
+
+  std::ofstream out(textFileName);
+  std::vector<BinaryTraceSink::Record> block(BinaryTraceSink::kRecordsPerBlock);
+  std::vector<bool> first;
+  size_t n;
+  while ((n = std::fread(block.data(), sizeof(BinaryTraceSink::Record), block.size(), in)) > 0)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      uint32_t flow = block[i].flow;
+      if (flow >= first.size())
+      {
+        first.resize(flow + 1, true);
+      }
+      if (first[flow])
+      {
+        if (per_flow)
+        {
+          out << flow << " ";
+        }
+        out << "0.0 " << NanoSeconds(block[i].oldval).GetSeconds() << '\n';
+        first[flow] = false;
+      }
+      if (per_flow)
+      {
+        out << flow << " ";
+      }
+      out << NanoSeconds(block[i].time).GetSeconds() << " " << NanoSeconds(block[i].newval).GetSeconds() << '\n';
+    }
+  }
+  std::fclose(in);
+  return 0;
+}
+
 void writeToFile(std::ofstream& stream, int parameter, double value, std::string fileName) {
   stream.open(fileName + ".data", std::ios_base::app);
   stream << parameter << " " << value << std::endl;
@@ -45,10 +276,10 @@ RttTracer(Time oldval, Time newval)
 {
   if (firstRtt)
   {
-    *rttStream->GetStream() << "0.0 " << oldval.GetSeconds() << std::endl;
+    *rttStream->GetStream() << "0.0 " << oldval.GetSeconds() << '\n';
     firstRtt = false;
   }
-  *rttStream->GetStream() << Simulator::Now().GetSeconds() << " " << newval.GetSeconds() << std::endl;
+  *rttStream->GetStream() << Simulator::Now().GetSeconds() << " " << newval.GetSeconds() << '\n';
 }
 
 static void
@@ -56,10 +287,84 @@ RtoTracer(Time oldval, Time newval)
 {
   if (firstRto)
   {
-    *rtoStream->GetStream() << "0.0 " << oldval.GetSeconds() << std::endl;
+    *rtoStream->GetStream() << "0.0 " << oldval.GetSeconds() << '\n';
     firstRto = false;
   }
-  *rtoStream->GetStream() << Simulator::Now().GetSeconds() << " " << newval.GetSeconds() << std::endl;
+  *rtoStream->GetStream() << Simulator::Now().GetSeconds() << " " << newval.GetSeconds() << '\n';
+}
+
+static void
+RttBinaryTracer(Time oldval, Time newval)
+{
+  rttSink->Add(oldval, newval);
+}
+
+static void
+RtoBinaryTracer(Time oldval, Time newval)
+{
+  rtoSink->Add(oldval, newval);
+}
+
+static void
+FlowRttTracer(uint32_t flow, Time oldval, Time newval)
+{
+  FlowStats& stats = flowStats[flow];
+  if (flowRttSink)
+  {
+    flowRttSink->Add(oldval, newval, flow);
+    return;
+  }
+  if (stats.firstRtt)
+  {
+    *flowRttStream->GetStream() << flow << " 0.0 " << oldval.GetSeconds() << '\n';
+    stats.firstRtt = false;
+  }
+  *flowRttStream->GetStream() << flow << " " << Simulator::Now().GetSeconds() << " " << newval.GetSeconds() << '\n';
+}
+
+// The RTT trace is SRTT; the ratio is taken on the samples themselves,
+// against the RTO they were measured under
+static void
+FlowRttSampleTracer(uint32_t flow, Time sample)
+{
+  FlowStats& stats = flowStats[flow];
+  if (sample.IsStrictlyPositive() && stats.rto.IsStrictlyPositive())
+  {
+    stats.ratio.Add(stats.rto.GetSeconds() / sample.GetSeconds());
+  }
+}
+
+static void
+FlowRtoTracer(uint32_t flow, Time oldval, Time newval)
+{
+  FlowStats& stats = flowStats[flow];
+  stats.rto = newval;
+  if (flowRtoSink)
+  {
+    flowRtoSink->Add(oldval, newval, flow);
+    return;
+  }
+  if (stats.firstRto)
+  {
+    *flowRtoStream->GetStream() << flow << " 0.0 " << oldval.GetSeconds() << '\n';
+    stats.firstRto = false;
+  }
+  *flowRtoStream->GetStream() << flow << " " << Simulator::Now().GetSeconds() << " " << newval.GetSeconds() << '\n';
+}
+
+static void
+FlowCongStateTracer(uint32_t flow, TcpSocketState::TcpCongState_t oldval, TcpSocketState::TcpCongState_t newval)
+{
+  if (newval == TcpSocketState::CA_LOSS && oldval != TcpSocketState::CA_LOSS)
+  {
+    flowStats[flow].loss_entries++;
+  }
+}
+
+static void
+FlowUndoneRtoTracer(uint32_t flow, uint32_t oldval, uint32_t newval)
+{
+  flowStats[flow].spurious += newval - oldval;
 }
 
 static void
@@ -93,21 +398,61 @@ RxTracer(const Ptr< const Packet > packet, const TcpHeader& header, const Ptr< c
 }
 
 static void
-TraceRtt(std::string rtt_tr_file_name)
+TraceRtt(std::string rtt_tr_file_name, bool binary)
 {
+  if (binary)
+  {
+    rttSink.reset(new BinaryTraceSink(rtt_tr_file_name));
+    Config::ConnectWithoutContext("/NodeList/0/$ns3::TcpL4Protocol/SocketList/0/RTT", MakeCallback(&RttBinaryTracer));
+    return;
+  }
   AsciiTraceHelper ascii;
   rttStream = ascii.CreateFileStream(rtt_tr_file_name.c_str());
   Config::ConnectWithoutContext("/NodeList/0/$ns3::TcpL4Protocol/SocketList/0/RTT", MakeCallback(&RttTracer));
 }
 
 static void
-TraceRto(std::string rto_tr_file_name)
+TraceRto(std::string rto_tr_file_name, bool binary)
 {
+  if (binary)
+  {
+    rtoSink.reset(new BinaryTraceSink(rto_tr_file_name));
+    Config::ConnectWithoutContext("/NodeList/0/$ns3::TcpL4Protocol/SocketList/0/RTO", MakeCallback(&RtoBinaryTracer));
+    return;
+  }
   AsciiTraceHelper ascii;
   rtoStream = ascii.CreateFileStream(rto_tr_file_name.c_str());
   Config::ConnectWithoutContext("/NodeList/0/$ns3::TcpL4Protocol/SocketList/0/RTO", MakeCallback(&RtoTracer));
 }
 
+// Connect the traces of the socket of one source to the shared per-flow
+// sinks; called once the source application has created its socket
+static void
+TraceFlow(uint32_t flow)
+{
+  std::string path = "/NodeList/" + std::to_string(flow) + "/$ns3::TcpL4Protocol/SocketList/0/";
+  Config::ConnectWithoutContext(path + "RTT", MakeBoundCallback(&FlowRttTracer, flow));
+  Config::ConnectWithoutContext(path + "RttSample", MakeBoundCallback(&FlowRttSampleTracer, flow));
+  Config::ConnectWithoutContext(path + "RTO", MakeBoundCallback(&FlowRtoTracer, flow));
+  Config::ConnectWithoutContext(path + "CongState", MakeBoundCallback(&FlowCongStateTracer, flow));
+  Config::ConnectWithoutContext(path + "UndoneRtos", MakeBoundCallback(&FlowUndoneRtoTracer, flow));
+}
+
+// Write one line of summary statistics per flow
+static void
+WriteFlowStats(std::string stats_file_name)
+{
+  std::ofstream out(stats_file_name);
+  out << "# flow rtt_samples loss_entries spurious_rtos rto_rtt_min rto_rtt_p50 rto_rtt_p90 rto_rtt_p99 rto_rtt_max\n";
+  for (size_t i = 0; i < flowStats.size(); i++)
+  {
+    const FlowStats& stats = flowStats[i];
+    out << i << " " << stats.ratio.Count() << " " << stats.loss_entries << " " << stats.spurious << " "
+      << stats.ratio.Min() << " " << stats.ratio.Quantile(0.5) << " " << stats.ratio.Quantile(0.9) << " "
+      << stats.ratio.Quantile(0.99) << " " << stats.ratio.Max() << '\n';
+  }
+}
+
 static void
 TraceRxDrop(std::string rxdrop_tr_file_name, NetDeviceContainer s_devices)
 {
@@ -119,15 +464,15 @@ TraceRxDrop(std::string rxdrop_tr_file_name, NetDeviceContainer s_devices)
 }
 
 static void
-TraceTxRx(int num_flows)
+TraceTxRx(uint32_t num_flows)
 {
   AsciiTraceHelper ascii;
   Config::ConnectWithoutContext("/NodeList/0/$ns3::TcpL4Protocol/SocketList/0/Tx", MakeCallback(&TxTracer));
   Config::ConnectWithoutContext("/NodeList/" + std::to_string(num_flows) + "/$ns3::TcpL4Protocol/SocketList/0/Rx", MakeCallback(&RxTracer));
 }
 
-int main(int argc, char* argv[])
-{
+// Parameters of one simulation
+struct SimConfig {
   std::string transport_prot = "TcpWestwood";
   double error_p = 0.0;
   std::string bottleneck_bandwidth = "10Mbps";
@@ -136,10 +481,13 @@ int main(int argc, char* argv[])
   std::string edge_delay = "120ms";
 
   bool tracing = true;
+  bool binary_trace = false;
+  bool per_flow_trace = false;
   std::string prefix_file_name = "RtoCompDemo";
   uint64_t data_mbytes = 0;
   uint32_t mtu_bytes = 1000;//400
-  uint16_t num_flows = 1;
+  uint32_t num_flows = 1;
+  double flow_start_interval = 0.1;  // seconds between the starts of two flows
   double duration = 10;
   uint32_t run = 0;
   bool flow_monitor = true;
@@ -148,32 +496,54 @@ int main(int argc, char* argv[])
   std::string queue_disc_type = "ns3::PfifoFastQueueDisc";
   std::string recovery = "ns3::TcpClassicRecovery";
   bool modified_rtt_calc = false;
+  std::string rtt_estimator = "ns3::RttMeanDeviation";
+  std::string rtt_filters = "";
+  std::string rto_policy = "ns3::RtoRfc6298";
+  bool undo_spurious_rto = false;
+  bool lazy_retx_timer = true;
+};
 
+// Metrics of one simulation, averaged over the flows
+struct SimResult {
+  double throughput = 0;  // kbps per flow
+  double drop = 0;        // % of the packets sent
+  double delay = 0;       // mean end-to-end delay, seconds
+  double setup_time = 0;  // wall clock to build the scenario, seconds
+  double run_time = 0;    // wall clock of Simulator::Run, seconds
+};
 
-  CommandLine cmd(__FILE__);
-  cmd.AddValue("transport_prot", "Transport protocol to use: TcpNewReno, TcpLinuxReno, "
-    "TcpHybla, TcpHighSpeed, TcpHtcp, TcpVegas, TcpScalable, TcpVeno, "
-    "TcpBic, TcpYeah, TcpIllinois, TcpWestwood, TcpWestwoodPlus, TcpLedbat, "
-    "TcpLp, TcpDctcp, TcpCubic, TcpBbr", transport_prot);
-  cmd.AddValue("error_p", "Packet error rate", error_p);
-  cmd.AddValue("bottleneck_bandwidth", "Bottleneck bandwidth", bottleneck_bandwidth);
-  cmd.AddValue("bottleneck_delay", "Bottleneck delay", bottleneck_delay);
-  cmd.AddValue("edge_bandwidth", "Edge link bandwidth", edge_bandwidth);
-  cmd.AddValue("edge_delay", "Edge link delay", edge_delay);
-  cmd.AddValue("tracing", "Flag to enable/disable tracing", tracing);
-  cmd.AddValue("prefix_name", "Prefix of output trace file", prefix_file_name);
-  cmd.AddValue("data", "Number of Megabytes of data to transmit", data_mbytes);
-  cmd.AddValue("mtu", "Size of IP packets to send in bytes", mtu_bytes);
-  cmd.AddValue("num_flows", "Number of flows", num_flows);
-  cmd.AddValue("duration", "Time to allow flows to run in seconds", duration);
-  cmd.AddValue("run", "Run index (for setting repeatable seeds)", run);
-  cmd.AddValue("flow_monitor", "Enable flow monitor", flow_monitor);
-  cmd.AddValue("pcap_tracing", "Enable or disable PCAP tracing", pcap);
-  cmd.AddValue("queue_disc_type", "Queue disc type for gateway (e.g. ns3::CoDelQueueDisc)", queue_disc_type);
-  cmd.AddValue("sack", "Enable or disable SACK option", sack);
-  cmd.AddValue("recovery", "Recovery algorithm type to use (e.g., ns3::TcpPrrRecovery", recovery);
-  cmd.AddValue("modified_rtt_calc", "Modification in RTT calculation", modified_rtt_calc);
-  cmd.Parse(argc, argv);
+static SimResult
+RunSimulation(const SimConfig& config)
+{
+  auto setup_start = std::chrono::steady_clock::now();
+  std::string transport_prot = config.transport_prot;
+  double error_p = config.error_p;
+  std::string bottleneck_bandwidth = config.bottleneck_bandwidth;
+  std::string bottleneck_delay = config.bottleneck_delay;
+  std::string edge_bandwidth = config.edge_bandwidth;
+  std::string edge_delay = config.edge_delay;
+
+  bool tracing = config.tracing;
+  bool binary_trace = config.binary_trace;
+  bool per_flow_trace = config.per_flow_trace;
+  std::string prefix_file_name = config.prefix_file_name;
+  uint64_t data_mbytes = config.data_mbytes;
+  uint32_t mtu_bytes = config.mtu_bytes;
+  uint32_t num_flows = config.num_flows;
+  double flow_start_interval = config.flow_start_interval;
+  double duration = config.duration;
+  uint32_t run = config.run;
+  bool flow_monitor = config.flow_monitor;
+  bool pcap = config.pcap;
+  bool sack = config.sack;
+  std::string queue_disc_type = config.queue_disc_type;
+  std::string recovery = config.recovery;
+  bool modified_rtt_calc = config.modified_rtt_calc;
+  std::string rtt_estimator = config.rtt_estimator;
+  std::string rtt_filters = config.rtt_filters;
+  std::string rto_policy = config.rto_policy;
+  bool undo_spurious_rto = config.undo_spurious_rto;
+  bool lazy_retx_timer = config.lazy_retx_timer;
 
   transport_prot = std::string("ns3::") + transport_prot;
 
@@ -205,12 +575,28 @@ int main(int argc, char* argv[])
   Config::SetDefault("ns3::TcpSocket::RcvBufSize", UintegerValue(1 << 21));
   Config::SetDefault("ns3::TcpSocket::SndBufSize", UintegerValue(1 << 21));
   Config::SetDefault("ns3::TcpSocketBase::Sack", BooleanValue(sack));
+  Config::SetDefault("ns3::TcpSocketBase::UndoSpuriousRto", BooleanValue(undo_spurious_rto));
+  Config::SetDefault("ns3::TcpSocketBase::LazyRetxTimer", BooleanValue(lazy_retx_timer));
 
   // Use modified version of RTT calculation if enabled
   if (modified_rtt_calc) {
     Config::SetDefault("ns3::RttMeanDeviation::Modified_RTT_Calc", BooleanValue(modified_rtt_calc));
   }
 
+  TypeId rttTid;
+  NS_ABORT_MSG_UNLESS(TypeId::LookupByNameFailSafe(rtt_estimator, &rttTid), "TypeId " << rtt_estimator << " not found");
+  if (!rtt_filters.empty()) {
+    // Feed the estimator through the given sample filters
+    Config::SetDefault("ns3::RttFilteredEstimator::EstimatorType", TypeIdValue(rttTid));
+    Config::SetDefault("ns3::RttFilteredEstimator::Filters", StringValue(rtt_filters));
+    rttTid = TypeId::LookupByName("ns3::RttFilteredEstimator");
+  }
+  Config::SetDefault("ns3::TcpL4Protocol::RttEstimatorType", TypeIdValue(rttTid));
+
+  TypeId rtoTid;
+  NS_ABORT_MSG_UNLESS(TypeId::LookupByNameFailSafe(rto_policy, &rtoTid), "TypeId " << rto_policy << " not found");
+  Config::SetDefault("ns3::TcpSocketBase::RtoPolicyType", TypeIdValue(rtoTid));
+
   Config::SetDefault("ns3::TcpL4Protocol::RecoveryType",
     TypeIdValue(TypeId::LookupByName(recovery)));
   // Select TCP variant
@@ -260,7 +646,8 @@ int main(int argc, char* argv[])
   tchCoDel.SetRootQueueDisc("ns3::CoDelQueueDisc");
 
   Ipv4AddressHelper address;
-  address.SetBase("10.0.0.0", "255.255.255.0");
+  // Two /30 networks per flow, enough for 10.0.0.0/8 to hold 2M flows
+  address.SetBase("10.0.0.0", "255.255.255.252");
 
   // Configure the sources and sinks net devices
   // and the channels between the sources/sinks and the gateways
@@ -290,8 +677,8 @@ int main(int argc, char* argv[])
 
   NetDeviceContainer routerDevices = bottleneckLink.Install(routers.Get(0), routers.Get(1));
   address.Assign(routerDevices);
-  NetDeviceContainer sourceDevices[num_flows];
-  NetDeviceContainer sinkDevices[num_flows];
+  std::vector<NetDeviceContainer> sourceDevices(num_flows);
+  std::vector<NetDeviceContainer> sinkDevices(num_flows);
 
   for (uint32_t i = 0; i < num_flows; i++)
   {
@@ -326,7 +713,7 @@ int main(int argc, char* argv[])
   PacketSinkHelper sinkHelper("ns3::TcpSocketFactory", sinkLocalAddress);
   ApplicationContainer sinkApp;
 
-  for (uint16_t i = 0; i < sources.GetN(); i++)
+  for (uint32_t i = 0; i < sources.GetN(); i++)
   {
     Address addr(InetSocketAddress(sink_interfaces.GetAddress(i, 0), port));
     AddressValue remoteAddress(InetSocketAddress(sink_interfaces.GetAddress(i, 0), port));
@@ -337,12 +724,12 @@ int main(int argc, char* argv[])
     ftp.SetAttribute("MaxBytes", UintegerValue(data_mbytes * 1000000));
 
     ApplicationContainer sourceApp = ftp.Install(sources.Get(i));
-    sourceApp.Start(Seconds(start_time * i));
+    sourceApp.Start(Seconds(flow_start_interval * i));
     sourceApp.Stop(Seconds(stop_time - 3));
 
     sinkHelper.SetAttribute("Protocol", TypeIdValue(TcpSocketFactory::GetTypeId()));
     sinkApp = sinkHelper.Install(sinks.Get(i));
-    sinkApp.Start(Seconds(start_time * i));
+    sinkApp.Start(Seconds(flow_start_interval * i));
     sinkApp.Stop(Seconds(stop_time));
   }
 
@@ -351,8 +738,31 @@ int main(int argc, char* argv[])
   {
     AsciiTraceHelper ascii;
     //bottleneckLink.EnableAsciiAll(ascii.CreateFileStream("throughput.tr"));
-    Simulator::Schedule(Seconds(0.00001), &TraceRtt, prefix_file_name + "-rtt.data");
-    Simulator::Schedule(Seconds(0.00001), &TraceRto, prefix_file_name + "-rto.data");
+    std::string ext = binary_trace ? ".bin" : ".data";
+    if (per_flow_trace)
+    {
+      // All flows share one RTT and one RTO sink, records carry the flow index
+      flowStats.assign(num_flows, FlowStats());
+      if (binary_trace)
+      {
+        flowRttSink.reset(new BinaryTraceSink(prefix_file_name + "-flow-rtt" + ext, true));
+        flowRtoSink.reset(new BinaryTraceSink(prefix_file_name + "-flow-rto" + ext, true));
+      }
+      else
+      {
+        flowRttStream = ascii.CreateFileStream(prefix_file_name + "-flow-rtt" + ext);
+        flowRtoStream = ascii.CreateFileStream(prefix_file_name + "-flow-rto" + ext);
+      }
+      for (uint32_t i = 0; i < num_flows; i++)
+      {
+        Simulator::Schedule(Seconds(flow_start_interval * i + 0.00001), &TraceFlow, i);
+      }
+    }
+    else
+    {
+      Simulator::Schedule(Seconds(0.00001), &TraceRtt, prefix_file_name + "-rtt" + ext, binary_trace);
+      Simulator::Schedule(Seconds(0.00001), &TraceRto, prefix_file_name + "-rto" + ext, binary_trace);
+    }
     Simulator::Schedule(Seconds(0.00001), &TraceRxDrop, prefix_file_name + "-rxdrop.data", routerDevices);
     Simulator::Schedule(Seconds(0.00001), &TraceTxRx, num_flows);
   }
@@ -372,7 +782,9 @@ int main(int argc, char* argv[])
   }
 
   Simulator::Stop(Seconds(stop_time));
+  auto run_start = std::chrono::steady_clock::now();
   Simulator::Run();
+  auto run_stop = std::chrono::steady_clock::now();
 
   //metric calculation
   double throughput = 0;
@@ -403,14 +815,320 @@ int main(int argc, char* argv[])
     }
   }
 
-  std::ofstream througputStream, dropStream, delayStream;
-  std::string f1 = "throughput";
-  std::string f2 = "drop";
-  std::string f3 = "delay";
-  writeToFile(througputStream, num_flows, throughput / num_flows, f1);
-  writeToFile(delayStream, num_flows, nPacketsDropped * 100 / (double)nPacketsSent, f2);
-  writeToFile(dropStream, num_flows, endToEndDelay / nPacketsReceived, f3);
+  // Sweep workers leave with _exit(), which skips the static destructors
+  if (rttSink)
+  {
+    rttSink->Close();
+  }
+  if (rtoSink)
+  {
+    rtoSink->Close();
+  }
+  if (rttStream)
+  {
+    rttStream->GetStream()->flush();
+  }
+  if (rtoStream)
+  {
+    rtoStream->GetStream()->flush();
+  }
+  if (!flowStats.empty())
+  {
+    WriteFlowStats(prefix_file_name + "-flow-stats.data");
+    if (flowRttSink)
+    {
+      flowRttSink->Close();
+      flowRtoSink->Close();
+    }
+    else
+    {
+      flowRttStream->GetStream()->flush();
+      flowRtoStream->GetStream()->flush();
+    }
+  }
+
+  SimResult result;
+  result.throughput = throughput / num_flows;
+  result.drop = nPacketsDropped * 100 / (double)nPacketsSent;
+  result.delay = endToEndDelay / nPacketsReceived;
+  result.setup_time = std::chrono::duration<double>(run_start - setup_start).count();
+  result.run_time = std::chrono::duration<double>(run_stop - run_start).count();
 
   Simulator::Destroy();
-  return 0;
-}
\ No newline at end of file
+  return result;
+}
+
+// Split a comma-separated list of values
+static std::vector<std::string>
+SplitList(const std::string& list)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+  {
+    if (!item.empty())
+    {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+// One line of the sweep output, filled in by the worker that ran it
+struct SweepSlot {
+  int done;
+  SimResult result;
+};
+
+/*
+ * Run every point of the grid, each in its own forked process since the
+ * simulator is a singleton. Up to `jobs` workers run at once, and a
+ * worker that finishes is replaced right away by one for the next point,
+ * so long simulations do not hold the others back. The workers store
+ * their results in shared memory; they are written out, one line per
+ * point in grid order, once all have exited. Each point seeds the
+ * generator with its own run index, so the output does not depend on
+ * the number of workers or on the scheduling.
+ *
+ * setup_time and run_time are wall-clock times, only comparable with
+ * --jobs=1. For instance, the cost of the retransmission timer with 1k
+ * to 100k flows, re-armed on every ACK and lazily:
+ *
+ *   --sweep --sweep_num_flows=1000,10000,100000 --sweep_lazy_retx_timer=0,1
+ *   --flow_start_interval=0.0001 --duration=5 --tracing=0 --flow_monitor=0 --jobs=1
+ */
+static int
+RunSweep(const std::vector<SimConfig>& grid, uint32_t jobs, std::string output_file_name)
+{
+  size_t n = grid.size();
+  void* shm = mmap(nullptr, std::max<size_t>(1, n) * sizeof(SweepSlot), PROT_READ | PROT_WRITE,
+    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  NS_ABORT_MSG_IF(shm == MAP_FAILED, "Cannot map the sweep results: " << std::strerror(errno));
+  SweepSlot* slots = static_cast<SweepSlot*>(shm);
+  for (size_t i = 0; i < n; i++)
+  {
+    slots[i].done = 0;
+  }
+
+  std::cout.flush();
+  std::cerr.flush();
+
+  size_t next = 0;
+  uint32_t running = 0;
+  bool failed = false;
+  while (next < n || running > 0)
+  {
+    while (next < n && running < jobs)
+    {
+      pid_t pid = fork();
+      NS_ABORT_MSG_IF(pid < 0, "Cannot fork a sweep worker: " << std::strerror(errno));
+      if (pid == 0)
+      {
+        slots[next].result = RunSimulation(grid[next]);
+        slots[next].done = 1;
+        _exit(0);
+      }
+      next++;
+      running++;
+    }
+
+    int status;
+    pid_t pid = wait(&status);
+    if (pid < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      break;
+    }
+    running--;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+      failed = true;
+    }
+  }
+
+  std::ofstream out(output_file_name);
+  out << "# num_flows error_p bottleneck_bandwidth modified_rtt_calc rtt_estimator lazy_retx_timer run "
+    "throughput drop delay setup_time run_time" << std::endl;
+  for (size_t i = 0; i < n; i++)
+  {
+    const SimConfig& c = grid[i];
+    out << c.num_flows << " " << c.error_p << " " << c.bottleneck_bandwidth << " "
+      << c.modified_rtt_calc << " " << c.rtt_estimator << " " << c.lazy_retx_timer << " " << c.run << " ";
+    if (slots[i].done)
+    {
+      out << slots[i].result.throughput << " " << slots[i].result.drop << " " << slots[i].result.delay << " "
+        << slots[i].result.setup_time << " " << slots[i].result.run_time;
+    }
+    else
+    {
+      out << "nan nan nan nan nan";
+      failed = true;
+    }
+    out << std::endl;
+  }
+  out.close();
+  munmap(shm, std::max<size_t>(1, n) * sizeof(SweepSlot));
+
+  NS_LOG_UNCOND("Sweep of " << n << " simulations written to " << output_file_name);
+  return failed ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+  SimConfig config;
+  bool sweep = false;
+  std::string sweep_num_flows = "";
+  std::string sweep_error_p = "";
+  std::string sweep_bandwidth = "";
+  std::string sweep_modified_rtt_calc = "";
+  std::string sweep_rtt_estimator = "";
+  std::string sweep_lazy_retx_timer = "";
+  uint32_t sweep_runs = 1;
+  uint32_t jobs = std::max<long>(1, sysconf(_SC_NPROCESSORS_ONLN));
+  std::string sweep_output = "sweep.data";
+  std::string convert_trace = "";
+
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("transport_prot", "Transport protocol to use: TcpNewReno, TcpLinuxReno, "
+    "TcpHybla, TcpHighSpeed, TcpHtcp, TcpVegas, TcpScalable, TcpVeno, "
+    "TcpBic, TcpYeah, TcpIllinois, TcpWestwood, TcpWestwoodPlus, TcpLedbat, "
+    "TcpLp, TcpDctcp, TcpCubic, TcpBbr", config.transport_prot);
+  cmd.AddValue("error_p", "Packet error rate", config.error_p);
+  cmd.AddValue("bottleneck_bandwidth", "Bottleneck bandwidth", config.bottleneck_bandwidth);
+  cmd.AddValue("bottleneck_delay", "Bottleneck delay", config.bottleneck_delay);
+  cmd.AddValue("edge_bandwidth", "Edge link bandwidth", config.edge_bandwidth);
+  cmd.AddValue("edge_delay", "Edge link delay", config.edge_delay);
+  cmd.AddValue("tracing", "Flag to enable/disable tracing", config.tracing);
+  cmd.AddValue("per_flow_trace", "Trace RTT/RTO of every flow into shared files, with per-flow statistics", config.per_flow_trace);
+  cmd.AddValue("binary_trace", "Write the RTT/RTO traces in binary, see convert_trace", config.binary_trace);
+  cmd.AddValue("convert_trace", "Convert a binary RTT/RTO trace to text (.bin -> .data) and exit", convert_trace);
+  cmd.AddValue("prefix_name", "Prefix of output trace file", config.prefix_file_name);
+  cmd.AddValue("data", "Number of Megabytes of data to transmit", config.data_mbytes);
+  cmd.AddValue("mtu", "Size of IP packets to send in bytes", config.mtu_bytes);
+  cmd.AddValue("num_flows", "Number of flows", config.num_flows);
+  cmd.AddValue("flow_start_interval", "Time between the starts of two flows in seconds", config.flow_start_interval);
+  cmd.AddValue("duration", "Time to allow flows to run in seconds", config.duration);
+  cmd.AddValue("run", "Run index (for setting repeatable seeds)", config.run);
+  cmd.AddValue("flow_monitor", "Enable flow monitor", config.flow_monitor);
+  cmd.AddValue("pcap_tracing", "Enable or disable PCAP tracing", config.pcap);
+  cmd.AddValue("queue_disc_type", "Queue disc type for gateway (e.g. ns3::CoDelQueueDisc)", config.queue_disc_type);
+  cmd.AddValue("sack", "Enable or disable SACK option", config.sack);
+  cmd.AddValue("recovery", "Recovery algorithm type to use (e.g., ns3::TcpPrrRecovery", config.recovery);
+  cmd.AddValue("modified_rtt_calc", "Modification in RTT calculation", config.modified_rtt_calc);
+  cmd.AddValue("rtt_estimator", "RTT estimator type to use: ns3::RttMeanDeviation, "
+    "ns3::RttLinuxMeanDeviation, ns3::RttKalman or ns3::RttHolt", config.rtt_estimator);
+  cmd.AddValue("rtt_filters", "Comma-separated RTT sample filters in front of the estimator "
+    "(e.g. ns3::RttHampelFilter,ns3::RttAckDelayFilter)", config.rtt_filters);
+  cmd.AddValue("rto_policy", "RTO policy type to use: ns3::RtoRfc6298, ns3::RtoLinux or ns3::RtoEifel", config.rto_policy);
+  cmd.AddValue("undo_spurious_rto", "Detect spurious RTOs (Eifel/F-RTO) and undo them", config.undo_spurious_rto);
+  cmd.AddValue("lazy_retx_timer", "Re-arm the retransmission timer lazily instead of on every ACK", config.lazy_retx_timer);
+  cmd.AddValue("sweep", "Run the grid given by the sweep_* values instead of a single simulation", sweep);
+  cmd.AddValue("sweep_num_flows", "Comma-separated numbers of flows to sweep (default: num_flows)", sweep_num_flows);
+  cmd.AddValue("sweep_error_p", "Comma-separated packet error rates to sweep (default: error_p)", sweep_error_p);
+  cmd.AddValue("sweep_bandwidth", "Comma-separated bottleneck bandwidths to sweep (default: bottleneck_bandwidth)", sweep_bandwidth);
+  cmd.AddValue("sweep_modified_rtt_calc", "Comma-separated 0/1 values of modified_rtt_calc to sweep (default: modified_rtt_calc)", sweep_modified_rtt_calc);
+  cmd.AddValue("sweep_rtt_estimator", "Comma-separated RTT estimator types to sweep (default: rtt_estimator)", sweep_rtt_estimator);
+  cmd.AddValue("sweep_lazy_retx_timer", "Comma-separated 0/1 values of lazy_retx_timer to sweep (default: lazy_retx_timer)", sweep_lazy_retx_timer);
+  cmd.AddValue("sweep_runs", "Number of run indices to sweep, starting at run", sweep_runs);
+  cmd.AddValue("jobs", "Number of simulations to run in parallel in a sweep", jobs);
+  cmd.AddValue("sweep_output", "Output file of the sweep", sweep_output);
+  cmd.Parse(argc, argv);
+
+  if (!convert_trace.empty())
+  {
+    std::string text_file_name = convert_trace;
+    size_t dot = text_file_name.rfind(".bin");
+    if (dot != std::string::npos && dot + 4 == text_file_name.size())
+    {
+      text_file_name.erase(dot);
+    }
+    return ConvertTrace(convert_trace, text_file_name + ".data");
+  }
+
+  if (!sweep)
+  {
+    SimResult result = RunSimulation(config);
+    NS_LOG_UNCOND("Wall clock: setup " << result.setup_time << " s, run " << result.run_time << " s");
+
+    std::ofstream througputStream, dropStream, delayStream;
+    std::string f1 = "throughput";
+    std::string f2 = "drop";
+    std::string f3 = "delay";
+    writeToFile(througputStream, config.num_flows, result.throughput, f1);
+    writeToFile(delayStream, config.num_flows, result.drop, f2);
+    writeToFile(dropStream, config.num_flows, result.delay, f3);
+    return 0;
+  }
+
+  std::vector<std::string> flows_list = SplitList(sweep_num_flows);
+  std::vector<std::string> error_list = SplitList(sweep_error_p);
+  std::vector<std::string> bandwidth_list = SplitList(sweep_bandwidth);
+  std::vector<std::string> modified_list = SplitList(sweep_modified_rtt_calc);
+  std::vector<std::string> estimator_list = SplitList(sweep_rtt_estimator);
+  std::vector<std::string> lazy_list = SplitList(sweep_lazy_retx_timer);
+  if (flows_list.empty())
+  {
+    flows_list.push_back(std::to_string(config.num_flows));
+  }
+  if (error_list.empty())
+  {
+    std::ostringstream oss;
+    oss << config.error_p;
+    error_list.push_back(oss.str());
+  }
+  if (bandwidth_list.empty())
+  {
+    bandwidth_list.push_back(config.bottleneck_bandwidth);
+  }
+  if (modified_list.empty())
+  {
+    modified_list.push_back(config.modified_rtt_calc ? "1" : "0");
+  }
+  if (estimator_list.empty())
+  {
+    estimator_list.push_back(config.rtt_estimator);
+  }
+  if (lazy_list.empty())
+  {
+    lazy_list.push_back(config.lazy_retx_timer ? "1" : "0");
+  }
+
+  std::vector<SimConfig> grid;
+  for (const std::string& flows : flows_list)
+  {
+    for (const std::string& error : error_list)
+    {
+      for (const std::string& bandwidth : bandwidth_list)
+      {
+        for (const std::string& modified : modified_list)
+        {
+          for (const std::string& estimator : estimator_list)
+          {
+            for (const std::string& lazy : lazy_list)
+            {
+              for (uint32_t r = 0; r < sweep_runs; r++)
+              {
+                SimConfig c = config;
+                c.num_flows = static_cast<uint32_t>(std::stoul(flows));
+                c.error_p = std::stod(error);
+                c.bottleneck_bandwidth = bandwidth;
+                c.modified_rtt_calc = (modified == "1" || modified == "true");
+                c.rtt_estimator = estimator;
+                c.lazy_retx_timer = (lazy == "1" || lazy == "true");
+                c.run = config.run + r;
+                c.prefix_file_name = config.prefix_file_name + "-" + std::to_string(grid.size());
+                grid.push_back(c);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return RunSweep(grid, std::max<uint32_t>(1, jobs), sweep_output);
+}
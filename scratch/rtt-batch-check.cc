@@ -0,0 +1,133 @@
+/*
+ * Checks that RttEstimator::MeasurementBatch leaves an estimator in the
+ * same state as one Measurement call per sample.
+ *
+ * The same random trace, with jumps, spikes and a run of equal samples,
+ * is replayed through two estimators of each kind: one sample at a time,
+ * and in batches of 1 to 17 samples. SRTT, RTTVAR, the number of samples,
+ * the previous sample and the gains in use must match exactly after every
+ * batch.
+ *
+ * ./ns3 run rtt-batch-check
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+using namespace ns3;
+
+// Exposes the previous sample, which the modified calculation works from
+class RttProbe : public RttMeanDeviation
+{
+public:
+  Time GetPrevRtt() const { return prev_rtt; }
+};
+
+struct Mode {
+  const char* name;
+  double alpha;
+  double beta;
+  bool modified;
+  bool fixed_point;
+};
+
+static Ptr<RttProbe>
+MakeEstimator(const Mode& mode)
+{
+  Ptr<RttProbe> rtt = CreateObject<RttProbe>();
+  rtt->SetAttribute("Alpha", DoubleValue(mode.alpha));
+  rtt->SetAttribute("Beta", DoubleValue(mode.beta));
+  rtt->SetAttribute("Modified_RTT_Calc", BooleanValue(mode.modified));
+  rtt->SetAttribute("FixedPoint", BooleanValue(mode.fixed_point));
+  return rtt;
+}
+
+static std::vector<Time>
+MakeTrace(uint32_t n)
+{
+  std::mt19937_64 gen(12345);
+  std::normal_distribution<double> jitter(0, 3e6);
+  std::uniform_real_distribution<double> u(0, 1);
+  std::vector<Time> trace;
+  double base = 50e6;
+  for (uint32_t i = 0; i < n; ++i) {
+    if (u(gen) < 0.01) {
+      base = 20e6 + u(gen) * 300e6;  // path change
+    }
+    double ns = base + jitter(gen);
+    if (u(gen) < 0.02) {
+      ns += 500e6;  // spike
+    }
+    if (i >= n / 2 && i < n / 2 + 40) {
+      ns = 80e6;  // run of equal samples
+    }
+    trace.push_back(NanoSeconds(static_cast<int64_t>(std::max(ns, 1e5))));
+  }
+  return trace;
+}
+
+static bool
+Same(const Ptr<RttProbe>& a, const Ptr<RttProbe>& b)
+{
+  return a->GetEstimate() == b->GetEstimate()
+      && a->GetVariation() == b->GetVariation()
+      && a->GetNSamples() == b->GetNSamples()
+      && a->GetPrevRtt() == b->GetPrevRtt()
+      && a->GetCurrentAlpha() == b->GetCurrentAlpha()
+      && a->GetCurrentBeta() == b->GetCurrentBeta();
+}
+
+int
+main(int argc, char* argv[])
+{
+  uint32_t samples = 20000;
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("samples", "Number of samples in the trace", samples);
+  cmd.Parse(argc, argv);
+
+  const Mode modes[] = {
+    {"classic, integer gains", 0.125, 0.25, false, false},
+    {"classic, floating point gains", 0.1, 0.3, false, false},
+    {"modified", 0.125, 0.25, true, false},
+    {"modified, fixed point", 0.125, 0.25, true, true},
+  };
+  std::vector<Time> trace = MakeTrace(samples);
+
+  int failures = 0;
+  for (const Mode& mode : modes) {
+    Ptr<RttProbe> single = MakeEstimator(mode);
+    Ptr<RttProbe> batched = MakeEstimator(mode);
+    size_t at = 0;
+    size_t batch = 1;
+    bool ok = true;
+    while (at < trace.size() && ok) {
+      size_t n = std::min(batch, trace.size() - at);
+      for (size_t i = at; i < at + n; ++i) {
+        single->Measurement(trace[i]);
+      }
+      batched->MeasurementBatch(trace.data() + at, n);
+      at += n;
+      batch = batch % 17 + 1;
+      if (!Same(single, batched)) {
+        ok = false;
+        std::cout << "  first mismatch after sample " << at
+                  << ": srtt " << single->GetEstimate().GetInteger() << " vs " << batched->GetEstimate().GetInteger()
+                  << ", rttvar " << single->GetVariation().GetInteger() << " vs " << batched->GetVariation().GetInteger()
+                  << ", samples " << single->GetNSamples() << " vs " << batched->GetNSamples()
+                  << ", prev " << single->GetPrevRtt().GetInteger() << " vs " << batched->GetPrevRtt().GetInteger()
+                  << std::endl;
+      }
+    }
+    std::cout << (ok ? "PASS " : "FAIL ") << mode.name << ": " << at << " samples" << std::endl;
+    failures += !ok;
+  }
+  std::cout << failures << " failure(s)" << std::endl;
+  return failures ? 1 : 0;
+}
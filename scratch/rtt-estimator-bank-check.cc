@@ -0,0 +1,126 @@
+/*
+ * Checks that RttEstimatorBank produces, lane for lane, exactly the state
+ * of RttMeanDeviation::IntegerUpdate.
+ *
+ * Each flow of a bank is shadowed by an RttMeanDeviation whose gains are
+ * the reciprocal powers of two of the bank's shifts, so that its
+ * Measurement () goes through IntegerUpdate (). Every pair of shifts that
+ * IntegerUpdate supports (1 to 5) is run over random samples, with flows
+ * that skip rounds, and over extreme ones: 1 ns, very large RTTs, jumps
+ * from one to the other and runs of equal samples. Banks of 1 flow and of
+ * 4k + 3 flows make the scalar tail run alone and after the vector kernel.
+ *
+ * The bank uses the kernel its file was compiled with (see
+ * RttEstimatorBank::GetKernelName): build ns-3 with -mavx2, with -msse4.2
+ * and without either to check each of them.
+ *
+ * ./ns3 run rtt-estimator-bank-check
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+using namespace ns3;
+
+static const int64_t HUGE_RTT = INT64_C(1) << 52;  // about 52 days, in ns
+
+// Sample of a flow in a round; zero or below for no sample
+static int64_t
+DrawSample(std::mt19937_64& gen, uint32_t pattern, uint32_t round, size_t flow)
+{
+  std::uniform_int_distribution<int64_t> any(1, HUGE_RTT);
+  std::uniform_int_distribution<int64_t> typical(100000, 500000000);
+  std::uniform_int_distribution<int> pick(0, 9);
+  switch (pattern) {
+  case 0:  // typical RTTs, with skipped rounds
+    return pick(gen) == 0 ? (pick(gen) < 5 ? 0 : -1) : typical(gen);
+  case 1:  // anywhere from 1 ns to HUGE_RTT
+    return any(gen);
+  default:  // extremes, jumps between them and runs of equal samples
+    switch ((round / 7 + flow) % 5) {
+    case 0: return 1;
+    case 1: return HUGE_RTT;
+    case 2: return round % 2 ? 1 : HUGE_RTT;
+    case 3: return 3;
+    default: return pick(gen) < 5 ? HUGE_RTT - 1 : 2;
+    }
+  }
+}
+
+static bool
+CheckBank(uint32_t rtt_shift, uint32_t variation_shift, size_t n_flows, uint32_t pattern, uint32_t rounds)
+{
+  std::mt19937_64 gen(rtt_shift * 1000 + variation_shift * 100 + n_flows + pattern);
+  RttEstimatorBank bank(n_flows, rtt_shift, variation_shift);
+  std::vector<Ptr<RttMeanDeviation>> shadows;
+  for (size_t i = 0; i < n_flows; ++i) {
+    Ptr<RttMeanDeviation> rtt = CreateObject<RttMeanDeviation>();
+    rtt->SetAttribute("Alpha", DoubleValue(1.0 / (1 << rtt_shift)));
+    rtt->SetAttribute("Beta", DoubleValue(1.0 / (1 << variation_shift)));
+    shadows.push_back(rtt);
+  }
+
+  std::vector<int64_t> samples(n_flows);
+  for (uint32_t round = 0; round < rounds; ++round) {
+    for (size_t i = 0; i < n_flows; ++i) {
+      samples[i] = DrawSample(gen, pattern, round, i);
+      if (samples[i] > 0) {
+        shadows[i]->Measurement(Time::From(samples[i]));
+      }
+    }
+    bank.Update(samples.data());
+    for (size_t i = 0; i < n_flows; ++i) {
+      if (bank.GetNSamples(i) != shadows[i]->GetNSamples()) {
+        std::cout << "  flow " << i << " has " << bank.GetNSamples(i) << " samples instead of "
+                  << shadows[i]->GetNSamples() << std::endl;
+        return false;
+      }
+      if (shadows[i]->GetNSamples() == 0) {
+        continue;  // no sample yet: each keeps its own initial estimate
+      }
+      if (bank.GetEstimate(i) != shadows[i]->GetEstimate()
+          || bank.GetVariation(i) != shadows[i]->GetVariation()) {
+        std::cout << "  shifts " << rtt_shift << "/" << variation_shift << ", " << n_flows
+                  << " flows, pattern " << pattern << ": flow " << i << " differs at round " << round
+                  << ": srtt " << bank.GetEstimate(i).GetInteger() << " vs " << shadows[i]->GetEstimate().GetInteger()
+                  << ", rttvar " << bank.GetVariation(i).GetInteger() << " vs " << shadows[i]->GetVariation().GetInteger()
+                  << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int
+main(int argc, char* argv[])
+{
+  uint32_t rounds = 300;
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("rounds", "Number of rounds of samples per bank", rounds);
+  cmd.Parse(argc, argv);
+
+  std::cout << "kernel: " << RttEstimatorBank::GetKernelName() << std::endl;
+  const char* patterns[] = {"random, skipped rounds", "random, 1 ns to 2^52 ns", "extremes"};
+  const size_t sizes[] = {1, 4 * 16 + 3};
+  int failures = 0;
+  for (uint32_t pattern = 0; pattern < 3; ++pattern) {
+    for (size_t n_flows : sizes) {
+      bool ok = true;
+      for (uint32_t rs = 1; rs <= 5; ++rs) {
+        for (uint32_t vs = 1; vs <= 5; ++vs) {
+          ok = CheckBank(rs, vs, n_flows, pattern, rounds) && ok;
+        }
+      }
+      std::cout << (ok ? "PASS " : "FAIL ") << patterns[pattern] << ", " << n_flows << " flow(s)" << std::endl;
+      failures += !ok;
+    }
+  }
+  std::cout << failures << " failure(s)" << std::endl;
+  return failures ? 1 : 0;
+}
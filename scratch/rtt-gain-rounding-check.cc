@@ -0,0 +1,95 @@
+/*
+ * Checks the gain adaptation of the fixed-point modified RTT calculation
+ * (RttMeanDeviation::FixedPoint) against the floating point one.
+ *
+ * Each case feeds two samples, prev and then curr, to one estimator of
+ * each kind, and compares the gains in use after the second sample. The
+ * gains start on Q.16 values and prev is 2^16 ns, so the rate of change
+ * (curr - prev) / prev is exact in both paths; only the rounding of the
+ * adapted gains differs. The fixed-point gains must be those of the
+ * floating point path rounded to the nearest Q.16 value, ties toward
+ * +infinity. With GainDecay, whose steps are rounded away from zero,
+ * they may differ by one Q.16 unit.
+ *
+ * ./ns3 run rtt-gain-rounding-check
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+using namespace ns3;
+
+static const int64_t ONE = 1 << 16;  // Q.16
+
+struct GainCase {
+  const char* name;
+  int64_t alpha;  // Q.16
+  int64_t beta;   // Q.16
+  int64_t delta;  // curr - prev, in ns; the rate is delta / 2^16
+  double decay;
+  int64_t tolerance;  // Q.16 units
+};
+
+static Ptr<RttMeanDeviation>
+MakeEstimator(const GainCase& c, bool fixed_point)
+{
+  Ptr<RttMeanDeviation> rtt = CreateObject<RttMeanDeviation>();
+  rtt->SetAttribute("Alpha", DoubleValue(static_cast<double>(c.alpha) / ONE));
+  rtt->SetAttribute("Beta", DoubleValue(static_cast<double>(c.beta) / ONE));
+  rtt->SetAttribute("Modified_RTT_Calc", BooleanValue(true));
+  rtt->SetAttribute("FixedPoint", BooleanValue(fixed_point));
+  rtt->SetAttribute("MinAlpha", DoubleValue(0));
+  rtt->SetAttribute("MinBeta", DoubleValue(0));
+  rtt->SetAttribute("GainDecay", DoubleValue(c.decay));
+  rtt->Measurement(NanoSeconds(ONE));
+  rtt->Measurement(NanoSeconds(ONE + c.delta));
+  return rtt;
+}
+
+static bool
+Check(const char* name, const char* gain, double reference, double fixed, int64_t tolerance)
+{
+  int64_t expected = static_cast<int64_t>(std::floor(reference * ONE + 0.5));
+  int64_t got = static_cast<int64_t>(fixed * ONE);
+  bool ok = std::llabs(got - expected) <= tolerance && fixed * ONE == got;
+  std::cout << (ok ? "PASS " : "FAIL ") << name << " " << gain
+            << ": double " << reference * ONE << " -> " << expected
+            << ", fixed point " << fixed * ONE << std::endl;
+  return ok;
+}
+
+int
+main(int argc, char* argv[])
+{
+  CommandLine cmd(__FILE__);
+  cmd.Parse(argc, argv);
+
+  // beta = 1/4: beta * rate falls on half a Q.16 unit when delta = 2 mod 4
+  const GainCase cases[] = {
+    {"positive rate, below a tie", 8192, 16384, 1, 0, 0},
+    {"positive rate, tie", 8192, 16384, 2, 0, 0},
+    {"positive rate, above a tie", 8192, 16384, 3, 0, 0},
+    {"negative rate, below a tie", 8192, 16384, -1, 0, 0},
+    {"negative rate, tie", 8192, 16384, -2, 0, 0},
+    {"negative rate, above a tie", 8192, 16384, -3, 0, 0},
+    {"odd gains, positive rate", 6554, 19661, 4099, 0, 0},
+    {"odd gains, negative rate", 6554, 19661, -4099, 0, 0},
+    {"odd gains, tie", 6553, 16385, 32768, 0, 0},
+    {"beta thrown below zero, decay", 8192, 16384, 5 * ONE, 0.1, 1},
+    {"alpha thrown above one, decay", 8192, 16384, 9 * ONE, 0.1, 1},
+  };
+
+  int failures = 0;
+  for (const GainCase& c : cases) {
+    Ptr<RttMeanDeviation> fp = MakeEstimator(c, false);
+    Ptr<RttMeanDeviation> fx = MakeEstimator(c, true);
+    failures += !Check(c.name, "alpha", fp->GetCurrentAlpha(), fx->GetCurrentAlpha(), c.tolerance);
+    failures += !Check(c.name, "beta", fp->GetCurrentBeta(), fx->GetCurrentBeta(), c.tolerance);
+  }
+  std::cout << failures << " failure(s)" << std::endl;
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Checks RttHampelFilter::Filter against a naive Hampel filter.
+ *
+ * The reference keeps the last WindowSize samples in arrival order and,
+ * for every sample, sorts a copy of them to take the median, then sorts
+ * their absolute deviations to take the MAD, both at index n / 2 as the
+ * filter does. Samples pass unchanged until the window holds 3 of them.
+ * The filtered sample and the outlier count must match exactly, over
+ * every window size, several thresholds and minimum deviations, and:
+ * random samples with spikes, samples drawn from a few values (many
+ * duplicates, MAD often zero), runs of equal samples, path changes, and
+ * resets that leave the window partially filled again.
+ *
+ * ./ns3 run rtt-hampel-check
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+using namespace ns3;
+
+// The filter, the slow way
+struct NaiveHampel {
+  uint32_t window_size;
+  double threshold;
+  int64_t min_deviation;
+  std::deque<int64_t> window;
+  uint32_t outliers = 0;
+
+  int64_t Filter(int64_t x)
+  {
+    window.push_back(x);
+    if (window.size() > window_size) {
+      window.pop_front();
+    }
+    size_t n = window.size();
+    if (n < 3) {
+      return x;
+    }
+    std::vector<int64_t> sorted(window.begin(), window.end());
+    std::sort(sorted.begin(), sorted.end());
+    int64_t median = sorted[n / 2];
+    std::vector<int64_t> deviations;
+    for (int64_t v : window) {
+      deviations.push_back(std::llabs(v - median));
+    }
+    std::sort(deviations.begin(), deviations.end());
+    int64_t mad = deviations[n / 2];
+    double sigma = std::max(1.4826 * static_cast<double>(mad), static_cast<double>(min_deviation));
+    if (static_cast<double>(std::llabs(x - median)) > threshold * sigma) {
+      outliers++;
+      return median;
+    }
+    return x;
+  }
+};
+
+// Sample in ns; pattern 0: random with spikes, 1: few values,
+// 2: runs of equal samples and path changes
+static int64_t
+DrawSample(std::mt19937_64& gen, uint32_t pattern, uint32_t i)
+{
+  std::uniform_int_distribution<int> pick(0, 99);
+  switch (pattern) {
+  case 0: {
+    std::normal_distribution<double> jitter(50e6, 5e6);
+    int64_t ns = std::max<int64_t>(1, static_cast<int64_t>(jitter(gen)));
+    return pick(gen) < 5 ? ns * 10 : ns;
+  }
+  case 1: {
+    const int64_t values[] = {40000000, 40000000, 40000001, 41000000, 90000000};
+    return values[pick(gen) % 5];
+  }
+  default:
+    if ((i / 40) % 3 == 0) {
+      return 30000000;
+    }
+    if ((i / 40) % 3 == 1) {
+      return 30000000 + (i % 2) * 500000;
+    }
+    return 200000000 + pick(gen) * 100000;
+  }
+}
+
+static bool
+Check(uint32_t window_size, double threshold, Time min_deviation, uint32_t pattern, uint32_t samples)
+{
+  Ptr<RttHampelFilter> filter = CreateObject<RttHampelFilter>();
+  filter->SetAttribute("WindowSize", UintegerValue(window_size));
+  filter->SetAttribute("Threshold", DoubleValue(threshold));
+  filter->SetAttribute("MinDeviation", TimeValue(min_deviation));
+  NaiveHampel naive{window_size, threshold, min_deviation.GetInteger()};
+
+  std::mt19937_64 gen(window_size * 100 + pattern);
+  std::uniform_int_distribution<int> reset(0, 499);
+  for (uint32_t i = 0; i < samples; ++i) {
+    if (reset(gen) == 0) {  // the window fills up again from empty
+      filter->Reset();
+      naive.window.clear();
+    }
+    int64_t x = DrawSample(gen, pattern, i);
+    Time sample = Time::From(x);
+    filter->Filter(sample);
+    int64_t expected = naive.Filter(x);
+    if (sample.GetInteger() != expected || filter->GetOutlierCount() != naive.outliers) {
+      std::cout << "  window " << window_size << ", threshold " << threshold << ", pattern " << pattern
+                << ": sample " << i << " (" << x << ", " << naive.window.size() << " in the window) gave "
+                << sample.GetInteger() << " instead of " << expected << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int
+main(int argc, char* argv[])
+{
+  uint32_t samples = 5000;
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("samples", "Number of samples per configuration", samples);
+  cmd.Parse(argc, argv);
+
+  const char* patterns[] = {"random, spikes", "few values, duplicates", "runs and path changes"};
+  const double thresholds[] = {0, 2, 5};
+  const Time min_deviations[] = {Seconds(0), MilliSeconds(1)};
+  int failures = 0;
+  for (uint32_t pattern = 0; pattern < 3; ++pattern) {
+    bool ok = true;
+    for (uint32_t window_size = 3; window_size <= RttHampelFilter::MAX_WINDOW; ++window_size) {
+      for (double threshold : thresholds) {
+        for (const Time& min_deviation : min_deviations) {
+          ok = Check(window_size, threshold, min_deviation, pattern, samples) && ok;
+        }
+      }
+    }
+    std::cout << (ok ? "PASS " : "FAIL ") << patterns[pattern] << std::endl;
+    failures += !ok;
+  }
+  std::cout << failures << " failure(s)" << std::endl;
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * Marking retransmissions in the RTT history: the linear scan that
+ * TcpSocketBase::UpdateRttHistory used to run, against the binary search
+ * of RttHistoryBuffer::Find.
+ *
+ * The checks replay the same operations on two histories, one marked by
+ * each method, and compare them entry by entry: a SYN entry, a partial
+ * retransmission that extends the count of an entry past the next ones,
+ * a history cleared with its maximum count reset, sequence numbers that
+ * wrap around, and random sends, retransmissions and ACKs.
+ *
+ * The benchmark fills the history with 10k to 100k segments in flight
+ * and retransmits all of them, oldest first: each linear scan walks the
+ * segments already retransmitted, O(n^2) in all.
+ *
+ * ./ns3 run rtt-history-bench
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+using namespace ns3;
+
+// The history of a socket, and the bound on its counts the socket keeps
+struct History {
+  RttHistoryBuffer buffer;
+  uint32_t max_count = 0;
+
+  void Send(SequenceNumber32 seq, uint32_t size)
+  {
+    buffer.PushBack(RttHistory(seq, size, Seconds(0)));
+    max_count = std::max(max_count, size);
+  }
+
+  void Clear()
+  {
+    buffer.Clear();
+    max_count = 0;
+  }
+
+  void Mark(RttHistory* h, SequenceNumber32 seq, uint32_t size)
+  {
+    if (h != nullptr) {
+      h->retx = true;
+      h->count = (seq + SequenceNumber32(size)) - h->seq;
+      max_count = std::max(max_count, h->count);
+    }
+  }
+};
+
+// UpdateRttHistory () before RttHistoryBuffer::Find
+static RttHistory*
+FindLinear(RttHistoryBuffer& buffer, SequenceNumber32 seq)
+{
+  for (uint32_t i = 0; i < buffer.GetSize(); ++i) {
+    RttHistory& h = buffer.Get(i);
+    if (seq >= h.seq && seq < h.seq + SequenceNumber32(h.count)) {
+      return &h;
+    }
+  }
+  return nullptr;
+}
+
+// Both histories, one marked by each method
+struct Histories {
+  History linear;
+  History binary;
+
+  void Send(SequenceNumber32 seq, uint32_t size)
+  {
+    linear.Send(seq, size);
+    binary.Send(seq, size);
+  }
+
+  void Clear()
+  {
+    linear.Clear();
+    binary.Clear();
+  }
+
+  void Ack()
+  {
+    linear.buffer.PopFront();
+    binary.buffer.PopFront();
+  }
+
+  // Returns false if the two methods marked different entries
+  bool Retransmit(SequenceNumber32 seq, uint32_t size)
+  {
+    RttHistory* a = FindLinear(linear.buffer, seq);
+    RttHistory* b = binary.buffer.Find(seq, binary.max_count);
+    linear.Mark(a, seq, size);
+    binary.Mark(b, seq, size);
+    if ((a == nullptr) != (b == nullptr)) {
+      return false;
+    }
+    if (linear.buffer.GetSize() != binary.buffer.GetSize()) {
+      return false;
+    }
+    for (uint32_t i = 0; i < linear.buffer.GetSize(); ++i) {
+      const RttHistory& x = linear.buffer.Get(i);
+      const RttHistory& y = binary.buffer.Get(i);
+      if (x.seq != y.seq || x.count != y.count || x.retx != y.retx) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+static bool
+Report(const std::string& name, bool ok)
+{
+  std::cout << (ok ? "PASS " : "FAIL ") << name << std::endl;
+  return ok;
+}
+
+static int
+RunChecks()
+{
+  int failures = 0;
+
+  {  // SYN: one entry of count 1 at the ISN
+    Histories p;
+    p.Send(SequenceNumber32(1000), 1);
+    bool ok = p.Retransmit(SequenceNumber32(1001), 1)  // past the SYN
+        && p.Retransmit(SequenceNumber32(1000), 1)
+        && p.binary.buffer.Front().retx && p.binary.buffer.Front().count == 1;
+    failures += !Report("SYN entry", ok);
+  }
+
+  {  // A partial retransmission that extends an entry past the next ones
+    Histories p;
+    for (uint32_t i = 0; i < 8; ++i) {
+      p.Send(SequenceNumber32(1000 + 500 * i), 500);
+    }
+    bool ok = p.Retransmit(SequenceNumber32(1200), 1000)  // 1000 now covers 1000..2200
+        && p.binary.max_count == 1200
+        && p.Retransmit(SequenceNumber32(2100), 500)      // the extended entry, not 2000
+        && p.binary.buffer.Get(0).count == 1600
+        && !p.binary.buffer.Get(2).retx
+        && p.Retransmit(SequenceNumber32(4400), 100);
+    failures += !Report("partial retransmission extending the count", ok);
+  }
+
+  {  // Cleared history, maximum count reset, smaller segments afterwards
+    Histories p;
+    for (uint32_t i = 0; i < 16; ++i) {
+      p.Send(SequenceNumber32(1448 * i), 1448);
+    }
+    bool ok = p.Retransmit(SequenceNumber32(0), 9000);
+    p.Clear();
+    ok = ok && p.binary.max_count == 0;
+    for (uint32_t i = 0; i < 16; ++i) {
+      p.Send(SequenceNumber32(20000 + 100 * i), 100);
+    }
+    ok = ok && p.binary.max_count == 100
+        && p.Retransmit(SequenceNumber32(100), 100)    // before the new history
+        && p.Retransmit(SequenceNumber32(20750), 100)
+        && p.Retransmit(SequenceNumber32(21650), 100); // past its end
+    failures += !Report("history cleared, maximum count reset", ok);
+  }
+
+  {  // Sequence numbers wrapping around 2^32
+    Histories p;
+    for (uint32_t i = 0; i < 64; ++i) {
+      p.Send(SequenceNumber32(0xffff0000u + 1000 * i), 1000);
+    }
+    bool ok = true;
+    for (uint32_t i = 0; i < 64 && ok; i += 3) {
+      ok = p.Retransmit(SequenceNumber32(0xffff0000u + 1000 * i + 999), 1000);
+    }
+    failures += !Report("sequence numbers wrapping around", ok);
+  }
+
+  {  // Random sends, retransmissions, ACKs and clears
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> op(0, 99);
+    std::uniform_int_distribution<uint32_t> size(1, 3000);
+    Histories p;
+    SequenceNumber32 next(0xfff00000u);
+    bool ok = true;
+    for (int i = 0; i < 200000 && ok; ++i) {
+      int o = op(gen);
+      if (o < 50 || p.linear.buffer.IsEmpty()) {
+        uint32_t s = size(gen);
+        p.Send(next, s);
+        next += s;
+      } else if (o < 85) {
+        // anywhere from just before the history to just after it
+        SequenceNumber32 first = p.linear.buffer.Front().seq;
+        uint32_t span = next - first;
+        std::uniform_int_distribution<uint32_t> off(0, span + 2000);
+        SequenceNumber32 seq = first + SequenceNumber32(off(gen)) - 1000;
+        ok = p.Retransmit(seq, size(gen));
+      } else if (o < 99) {
+        p.Ack();
+      } else {
+        p.Clear();
+      }
+    }
+    failures += !Report("random operations", ok);
+  }
+  return failures;
+}
+
+static void
+RunBenchmark()
+{
+  std::printf("%10s %14s %14s\n", "in flight", "linear scan", "binary search");
+  const uint32_t sizes[] = {10000, 30000, 100000};
+  for (uint32_t n : sizes) {
+    double ms[2];
+    for (int method = 0; method < 2; ++method) {
+      History h;
+      h.buffer.Reserve(n);
+      for (uint32_t i = 0; i < n; ++i) {
+        h.Send(SequenceNumber32(1448 * i), 1448);
+      }
+      auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < n; ++i) {
+        SequenceNumber32 seq(1448 * i);
+        RttHistory* found = method == 0 ? FindLinear(h.buffer, seq) : h.buffer.Find(seq, h.max_count);
+        h.Mark(found, seq, 1448);
+      }
+      auto stop = std::chrono::steady_clock::now();
+      ms[method] = std::chrono::duration<double, std::milli>(stop - start).count();
+    }
+    std::printf("%10u %11.1f ms %11.2f ms\n", n, ms[0], ms[1]);
+  }
+}
+
+int
+main(int argc, char* argv[])
+{
+  bool bench = true;
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("bench", "Run the benchmark after the checks", bench);
+  cmd.Parse(argc, argv);
+
+  int failures = RunChecks();
+  std::cout << failures << " failure(s)" << std::endl;
+  if (bench) {
+    RunBenchmark();
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Microbenchmark of RttMeanDeviation::Measurement, in ns per call.
+ *
+ * "after" is the current estimator, which works out whether its gains are
+ * reciprocal powers of two when they change. "before" adds, on every
+ * call, the classification the estimator used to run on every call: the
+ * original CheckForReciprocalPowerOfTwo (), copied below, on both gains.
+ * Both run in classic mode, with integer and with floating point gains,
+ * and in modified mode.
+ *
+ * ./ns3 run "rtt-measurement-bench --samples=2000000"
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+
+using namespace ns3;
+
+// RttMeanDeviation::CheckForReciprocalPowerOfTwo () before gains were
+// classified on change
+static uint32_t
+OldCheckForReciprocalPowerOfTwo(double val)
+{
+  const double tolerance = 1e-6;
+  if (val < tolerance) {
+    return 0;
+  }
+  if (std::abs(1 / val - 8) < tolerance) {
+    return 3;
+  }
+  if (std::abs(1 / val - 4) < tolerance) {
+    return 2;
+  }
+  if (std::abs(1 / val - 32) < tolerance) {
+    return 5;
+  }
+  if (std::abs(1 / val - 16) < tolerance) {
+    return 4;
+  }
+  if (std::abs(1 / val - 2) < tolerance) {
+    return 1;
+  }
+  return 0;
+}
+
+struct Mode {
+  const char* name;
+  double alpha;
+  double beta;
+  bool modified;
+};
+
+static Ptr<RttMeanDeviation>
+MakeEstimator(const Mode& mode)
+{
+  Ptr<RttMeanDeviation> rtt = CreateObject<RttMeanDeviation>();
+  rtt->SetAttribute("Alpha", DoubleValue(mode.alpha));
+  rtt->SetAttribute("Beta", DoubleValue(mode.beta));
+  rtt->SetAttribute("Modified_RTT_Calc", BooleanValue(mode.modified));
+  return rtt;
+}
+
+static volatile uint32_t sink;
+
+// ns per Measurement () call, best of a few runs
+static double
+Bench(const Mode& mode, const std::vector<Time>& trace, bool before)
+{
+  double best = 1e30;
+  for (int run = 0; run < 5; ++run) {
+    Ptr<RttMeanDeviation> rtt = MakeEstimator(mode);
+    uint32_t shifts = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const Time& sample : trace) {
+      if (before) {
+        shifts += OldCheckForReciprocalPowerOfTwo(rtt->GetCurrentAlpha());
+        shifts += OldCheckForReciprocalPowerOfTwo(rtt->GetCurrentBeta());
+      }
+      rtt->Measurement(sample);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    sink = shifts + rtt->GetNSamples();
+    best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count() / trace.size());
+  }
+  return best;
+}
+
+int
+main(int argc, char* argv[])
+{
+  uint32_t samples = 2000000;
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("samples", "Number of samples per run", samples);
+  cmd.Parse(argc, argv);
+
+  std::mt19937_64 gen(1);
+  std::normal_distribution<double> jitter(0, 2e6);
+  std::vector<Time> trace;
+  for (uint32_t i = 0; i < samples; ++i) {
+    trace.push_back(NanoSeconds(static_cast<int64_t>(50e6 + jitter(gen))));
+  }
+
+  const Mode modes[] = {
+    {"classic, gains 1/8 and 1/4", 0.125, 0.25, false},
+    {"classic, gains 0.1 and 0.3", 0.1, 0.3, false},
+    {"modified", 0.125, 0.25, true},
+  };
+  std::printf("%-30s %10s %10s\n", "mode", "before", "after");
+  for (const Mode& mode : modes) {
+    double before = Bench(mode, trace, true);
+    double after = Bench(mode, trace, false);
+    std::printf("%-30s %7.1f ns %7.1f ns\n", mode.name, before, after);
+  }
+  return 0;
+}
@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "min-rtt-filter.h"
+
+namespace ns3 {
+
+MinRttFilter::MinRttFilter (Time window)
+  : m_window (window)
+{
+  Reset ();
+}
+
+void
+MinRttFilter::SetWindow (Time window)
+{
+  m_window = window;
+}
+
+Time
+MinRttFilter::GetWindow (void) const
+{
+  return m_window;
+}
+
+Time
+MinRttFilter::GetMin (void) const
+{
+  return m_best[0].value;
+}
+
+void
+MinRttFilter::Reset (void)
+{
+  for (Sample &s : m_best)
+    {
+      s.time = Time (0);
+      s.value = Time::Max ();
+    }
+}
+
+Time
+MinRttFilter::Restart (const Sample &s)
+{
+  m_best[0] = m_best[1] = m_best[2] = s;
+  return s.value;
+}
+
+Time
+MinRttFilter::Update (Time now, Time sample)
+{
+  Sample s = {now, sample};
+
+  if (s.value <= m_best[0].value
+      || (m_window.IsStrictlyPositive () && s.time - m_best[2].time > m_window))
+    {
+      // New minimum, or nothing seen for a whole window
+      return Restart (s);
+    }
+
+  if (s.value <= m_best[1].value)
+    {
+      m_best[2] = m_best[1] = s;
+    }
+  else if (s.value <= m_best[2].value)
+    {
+      m_best[2] = s;
+    }
+
+  if (!m_window.IsStrictlyPositive ())
+    {
+      return m_best[0].value;
+    }
+  return UpdateSubWindows (s);
+}
+
+Time
+MinRttFilter::UpdateSubWindows (const Sample &s)
+{
+  Time dt = s.time - m_best[0].time;
+
+  if (dt > m_window)
+    {
+      // The best sample is out of the window: the next best take over.
+      // If the new best is out too, the newest sample takes over
+      m_best[0] = m_best[1];
+      m_best[1] = m_best[2];
+      m_best[2] = s;
+      if (s.time - m_best[0].time > m_window)
+        {
+          m_best[0] = m_best[1];
+          m_best[1] = m_best[2];
+          m_best[2] = s;
+        }
+    }
+  else if (m_best[1].time == m_best[0].time && dt > m_window / 4)
+    {
+      // A quarter of the window passed without a 2nd best: take one from
+      // the second quarter
+      m_best[2] = m_best[1] = s;
+    }
+  else if (m_best[2].time == m_best[1].time && dt > m_window / 2)
+    {
+      // Half of the window passed without a 3rd best: take one from the
+      // second half
+      m_best[2] = s;
+    }
+  return m_best[0].value;
+}
+
+} // namespace ns3
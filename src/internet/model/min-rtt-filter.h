@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef MIN_RTT_FILTER_H
+#define MIN_RTT_FILTER_H
+
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Windowed minimum of the RTT (Kathleen Nichols' algorithm)
+ *
+ * Tracks the minimum of the samples seen over the last window of time,
+ * as the minmax filter of BBR (lib/win_minmax.c in Linux).  Three samples
+ * are kept: the best one over the window, and the best ones over its
+ * last three quarters and its last half, which take over as the best
+ * one ages out.  An update is O(1), whatever the number of samples in the
+ * window.
+ *
+ * A zero window never forgets: the filter then keeps the minimum of all
+ * the samples.
+ */
+class MinRttFilter
+{
+public:
+  /**
+   * \brief Constructor
+   * \param window length of the window
+   */
+  MinRttFilter (Time window = Seconds (10.0));
+
+  /**
+   * \brief Set the length of the window
+   * \param window length of the window, zero to never forget
+   */
+  void SetWindow (Time window);
+
+  /**
+   * \brief Get the length of the window
+   * \return the length of the window
+   */
+  Time GetWindow (void) const;
+
+  /**
+   * \brief Add a sample
+   * \param now the time of the sample
+   * \param sample the RTT sample
+   * \return the minimum over the window ending at now
+   */
+  Time Update (Time now, Time sample);
+
+  /**
+   * \brief Get the minimum over the window ending at the last update
+   * \return the minimum, Time::Max () if there is no sample
+   */
+  Time GetMin (void) const;
+
+  /**
+   * \brief Forget every sample
+   */
+  void Reset (void);
+
+private:
+  /**
+   * \brief A sample and its time
+   */
+  struct Sample
+  {
+    Time time;  //!< Time of the sample
+    Time value; //!< Value of the sample
+  };
+
+  /**
+   * \brief Make a sample the only one of the filter
+   * \param s the sample
+   * \return its value
+   */
+  Time Restart (const Sample &s);
+
+  /**
+   * \brief Age the kept samples out of their sub-windows
+   * \param s the newest sample
+   * \return the minimum over the window
+   */
+  Time UpdateSubWindows (const Sample &s);
+
+  Time   m_window;   //!< Length of the window, zero for no window
+  Sample m_best[3];  //!< Best, 2nd best and 3rd best samples
+};
+
+} // namespace ns3
+
+#endif /* MIN_RTT_FILTER_H */
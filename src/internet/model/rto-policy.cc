@@ -0,0 +1,391 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "rto-policy.h"
+#include "rtt-estimator.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RtoPolicy");
+
+NS_OBJECT_ENSURE_REGISTERED (RtoPolicy);
+
+TypeId
+RtoPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RtoPolicy")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddAttribute ("MaxRto",
+                   "Maximum retransmission timeout, RFC 6298 requires at least 60 s",
+                   TimeValue (Seconds (60.0)),
+                   MakeTimeAccessor (&RtoPolicy::SetMaxRto,
+                                     &RtoPolicy::GetMaxRto),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+RtoPolicy::RtoPolicy ()
+  : m_minRto (Seconds (1.0)),
+    m_clockGranularity (MilliSeconds (1))
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RtoPolicy::RtoPolicy (const RtoPolicy &p)
+  : Object (p),
+    m_minRto (p.m_minRto),
+    m_clockGranularity (p.m_clockGranularity),
+    m_maxRto (p.m_maxRto),
+    m_version (p.m_version)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RtoPolicy::~RtoPolicy ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Time
+RtoPolicy::Clamp (Time rto) const
+{
+  return Min (Max (rto, m_minRto), m_maxRto);
+}
+
+Time
+RtoPolicy::Backoff (Time rto) const
+{
+  return Min (rto + rto, m_maxRto);
+}
+
+void
+RtoPolicy::AddSample (Time sample, Time estimate)
+{
+  NS_LOG_FUNCTION (this << sample << estimate);
+}
+
+void
+RtoPolicy::Reset (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+RtoPolicy::SetMinRto (Time minRto)
+{
+  NS_LOG_FUNCTION (this << minRto);
+  m_minRto = minRto;
+  NotifyChanged ();
+}
+
+Time
+RtoPolicy::GetMinRto (void) const
+{
+  return m_minRto;
+}
+
+void
+RtoPolicy::SetClockGranularity (Time clockGranularity)
+{
+  NS_LOG_FUNCTION (this << clockGranularity);
+  m_clockGranularity = clockGranularity;
+  NotifyChanged ();
+}
+
+Time
+RtoPolicy::GetClockGranularity (void) const
+{
+  return m_clockGranularity;
+}
+
+void
+RtoPolicy::SetMaxRto (Time maxRto)
+{
+  NS_LOG_FUNCTION (this << maxRto);
+  m_maxRto = maxRto;
+  NotifyChanged ();
+}
+
+Time
+RtoPolicy::GetMaxRto (void) const
+{
+  return m_maxRto;
+}
+
+uint32_t
+RtoPolicy::GetVersion (void) const
+{
+  return m_version;
+}
+
+void
+RtoPolicy::NotifyChanged (void)
+{
+  m_version++;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// RFC 6298
+
+NS_OBJECT_ENSURE_REGISTERED (RtoRfc6298);
+
+TypeId
+RtoRfc6298::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RtoRfc6298")
+    .SetParent<RtoPolicy> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RtoRfc6298> ()
+    .AddAttribute ("K",
+                   "Multiplier of the RTT variation",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&RtoRfc6298::SetK,
+                                         &RtoRfc6298::GetK),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+RtoRfc6298::RtoRfc6298 ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RtoRfc6298::RtoRfc6298 (const RtoRfc6298 &p)
+  : RtoPolicy (p),
+    m_k (p.m_k)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+RtoRfc6298::SetK (uint32_t k)
+{
+  NS_LOG_FUNCTION (this << k);
+  m_k = k;
+  NotifyChanged ();
+}
+
+uint32_t
+RtoRfc6298::GetK (void) const
+{
+  return m_k;
+}
+
+Time
+RtoRfc6298::ComputeRto (Ptr<const RttEstimator> rtt) const
+{
+  // RFC 6298, clause 2.3
+  return rtt->GetEstimate () + Max (m_clockGranularity, rtt->GetVariation () * m_k);
+}
+
+Ptr<RtoPolicy>
+RtoRfc6298::Copy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return CopyObject<RtoRfc6298> (this);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Linux
+
+NS_OBJECT_ENSURE_REGISTERED (RtoLinux);
+
+TypeId
+RtoLinux::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RtoLinux")
+    .SetParent<RtoPolicy> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RtoLinux> ()
+    .AddAttribute ("MinRttVar",
+                   "Floor of the variation term of the retransmission timeout (TCP_RTO_MIN)",
+                   TimeValue (MilliSeconds (200)),
+                   MakeTimeAccessor (&RtoLinux::SetMinRttVar,
+                                     &RtoLinux::GetMinRttVar),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+RtoLinux::RtoLinux ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RtoLinux::RtoLinux (const RtoLinux &p)
+  : RtoPolicy (p),
+    m_minRttVar (p.m_minRttVar)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+RtoLinux::SetMinRttVar (Time minRttVar)
+{
+  NS_LOG_FUNCTION (this << minRttVar);
+  m_minRttVar = minRttVar;
+  NotifyChanged ();
+}
+
+Time
+RtoLinux::GetMinRttVar (void) const
+{
+  return m_minRttVar;
+}
+
+Time
+RtoLinux::ComputeRto (Ptr<const RttEstimator> rtt) const
+{
+  // __tcp_set_rto () in net/ipv4/tcp_input.c
+  return rtt->GetEstimate () + Max (rtt->GetVariation () * 4, m_minRttVar);
+}
+
+Ptr<RtoPolicy>
+RtoLinux::Copy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return CopyObject<RtoLinux> (this);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Eifel
+
+NS_OBJECT_ENSURE_REGISTERED (RtoEifel);
+
+TypeId
+RtoEifel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RtoEifel")
+    .SetParent<RtoPolicy> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RtoEifel> ()
+    .AddAttribute ("K",
+                   "Multiplier of the RTT variation",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&RtoEifel::SetK,
+                                         &RtoEifel::GetK),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("VariationGain",
+                   "Gain of the variation, fed by the samples above the estimate",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&RtoEifel::SetVariationGain,
+                                       &RtoEifel::GetVariationGain),
+                   MakeDoubleChecker<double> (0, 1))
+  ;
+  return tid;
+}
+
+RtoEifel::RtoEifel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RtoEifel::RtoEifel (const RtoEifel &p)
+  : RtoPolicy (p),
+    m_k (p.m_k),
+    m_gain (p.m_gain),
+    m_variation (p.m_variation),
+    m_lastSample (p.m_lastSample),
+    m_sampled (p.m_sampled)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Time
+RtoEifel::ComputeRto (Ptr<const RttEstimator> rtt) const
+{
+  if (!m_sampled)
+    {
+      return rtt->GetEstimate () + Max (m_clockGranularity, rtt->GetVariation () * m_k);
+    }
+  Time rto = rtt->GetEstimate () + Max (m_clockGranularity, m_variation * m_k);
+  return Max (rto, m_lastSample + m_clockGranularity * 2);
+}
+
+Ptr<RtoPolicy>
+RtoEifel::Copy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return CopyObject<RtoEifel> (this);
+}
+
+void
+RtoEifel::AddSample (Time sample, Time estimate)
+{
+  NS_LOG_FUNCTION (this << sample << estimate);
+  if (!m_sampled)
+    {
+      // As the first sample of RFC 6298, clause 2.2
+      m_variation = sample / 2;
+      m_sampled = true;
+    }
+  else if (sample > estimate)
+    {
+      // Only the samples above the estimate feed the variation
+      Time delta = sample - estimate;
+      m_variation += (delta - m_variation) * m_gain;
+    }
+  m_lastSample = sample;
+  NotifyChanged ();
+}
+
+void
+RtoEifel::Reset (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_variation = Time (0);
+  m_lastSample = Time (0);
+  m_sampled = false;
+  NotifyChanged ();
+}
+
+void
+RtoEifel::SetK (uint32_t k)
+{
+  NS_LOG_FUNCTION (this << k);
+  m_k = k;
+  NotifyChanged ();
+}
+
+uint32_t
+RtoEifel::GetK (void) const
+{
+  return m_k;
+}
+
+void
+RtoEifel::SetVariationGain (double gain)
+{
+  NS_LOG_FUNCTION (this << gain);
+  m_gain = gain;
+}
+
+double
+RtoEifel::GetVariationGain (void) const
+{
+  return m_gain;
+}
+
+} // namespace ns3
@@ -0,0 +1,335 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef RTO_POLICY_H
+#define RTO_POLICY_H
+
+#include <stdint.h>
+
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+
+namespace ns3 {
+
+class RttEstimator;
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Base class for the derivation of the retransmission timeout
+ *
+ * An RtoPolicy turns the state of an RttEstimator into a retransmission
+ * timeout, clamps it, and backs it off when the timer expires.  The
+ * minimum RTO and the clock granularity are configured on the socket,
+ * which forwards them to its policy; the maximum RTO belongs to the
+ * policy.
+ *
+ * The socket caches the RTO and only asks the policy again when the
+ * estimate or the variation of the estimator change, or when the version
+ * of the policy does, so ComputeRto should only depend on those and on
+ * the policy's own parameters.  Every setter of such a parameter calls
+ * NotifyChanged (), so that changing an attribute of a live policy, e.g.
+ * with Config::Set, takes effect at once.
+ */
+class RtoPolicy : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RtoPolicy ();
+  /**
+   * \brief Copy constructor
+   * \param p the object to copy
+   */
+  RtoPolicy (const RtoPolicy &p);
+
+  virtual ~RtoPolicy ();
+
+  /**
+   * \brief Compute the retransmission timeout, before clamping
+   * \param rtt the RTT estimator
+   * \return the retransmission timeout
+   */
+  virtual Time ComputeRto (Ptr<const RttEstimator> rtt) const = 0;
+
+  /**
+   * \brief Bound a retransmission timeout to [MinRto, MaxRto]
+   * \param rto the retransmission timeout
+   * \return the bounded retransmission timeout
+   */
+  virtual Time Clamp (Time rto) const;
+
+  /**
+   * \brief Back off the retransmission timeout after an expiry
+   *
+   * The default doubles it (RFC 6298, clause 5.5), up to MaxRto.
+   *
+   * \param rto the retransmission timeout that expired
+   * \return the retransmission timeout for the next attempt
+   */
+  virtual Time Backoff (Time rto) const;
+
+  /**
+   * \brief Copy the policy (including its parameters)
+   * \return a copy of itself
+   */
+  virtual Ptr<RtoPolicy> Copy (void) const = 0;
+
+  /**
+   * \brief Take an RTT sample, for policies that keep their own state
+   *
+   * Called by the socket once the estimator has taken the samples of an
+   * ACK.  The default does nothing.
+   *
+   * \param sample the RTT sample
+   * \param estimate the RTT estimate before the samples of the ACK
+   */
+  virtual void AddSample (Time sample, Time estimate);
+
+  /**
+   * \brief Forget the samples taken, along with the estimator
+   *
+   * The default does nothing.
+   */
+  virtual void Reset (void);
+
+  /**
+   * \brief Set the minimum retransmission timeout
+   * \param minRto the minimum retransmission timeout
+   */
+  void SetMinRto (Time minRto);
+
+  /**
+   * \brief Get the minimum retransmission timeout
+   * \return the minimum retransmission timeout
+   */
+  Time GetMinRto (void) const;
+
+  /**
+   * \brief Set the clock granularity used in the RTO computation
+   * \param clockGranularity the clock granularity
+   */
+  void SetClockGranularity (Time clockGranularity);
+
+  /**
+   * \brief Get the clock granularity used in the RTO computation
+   * \return the clock granularity
+   */
+  Time GetClockGranularity (void) const;
+
+  /**
+   * \brief Set the maximum retransmission timeout
+   * \param maxRto the maximum retransmission timeout
+   */
+  void SetMaxRto (Time maxRto);
+
+  /**
+   * \brief Get the maximum retransmission timeout
+   * \return the maximum retransmission timeout
+   */
+  Time GetMaxRto (void) const;
+
+  /**
+   * \brief Get the version of the parameters of the policy
+   *
+   * The version changes whenever a parameter the RTO depends on does, so
+   * that a cached RTO can be checked against it.
+   *
+   * \return the version of the parameters
+   */
+  uint32_t GetVersion (void) const;
+
+protected:
+  /**
+   * \brief Note a change of a parameter the RTO depends on
+   */
+  void NotifyChanged (void);
+
+  Time     m_minRto;           //!< Minimum retransmission timeout
+  Time     m_clockGranularity; //!< Clock granularity used in RTO computation
+  Time     m_maxRto;           //!< Maximum retransmission timeout
+  uint32_t m_version {0};      //!< Version of the parameters, see GetVersion ()
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief The retransmission timeout of RFC 6298
+ *
+ * RTO = SRTT + max (G, K * RTTVAR), with K = 4 by default.
+ *
+ * This is also the policy of the improved RTO algorithm of this model:
+ * its modified calculation adapts the gains of the estimator
+ * (RttMeanDeviation::Modified_RTT_Calc), and keeps the RFC 6298 formula.
+ */
+class RtoRfc6298 : public RtoPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RtoRfc6298 ();
+  /**
+   * \brief Copy constructor
+   * \param p the object to copy
+   */
+  RtoRfc6298 (const RtoRfc6298 &p);
+
+  virtual Time ComputeRto (Ptr<const RttEstimator> rtt) const;
+  virtual Ptr<RtoPolicy> Copy (void) const;
+
+private:
+  /**
+   * \brief Set the multiplier of the RTT variation
+   * \param k the multiplier
+   */
+  void SetK (uint32_t k);
+
+  /**
+   * \brief Get the multiplier of the RTT variation
+   * \return the multiplier
+   */
+  uint32_t GetK (void) const;
+
+  uint32_t m_k; //!< Multiplier of the RTT variation
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief The retransmission timeout of Linux
+ *
+ * Linux floors the variation term instead of the whole timeout:
+ * RTO = SRTT + max (4 * RTTVAR, MinRttVar), with MinRttVar = 200 ms
+ * (TCP_RTO_MIN).  The socket MinRto still applies on top of it, and
+ * should be lowered accordingly.
+ */
+class RtoLinux : public RtoPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RtoLinux ();
+  /**
+   * \brief Copy constructor
+   * \param p the object to copy
+   */
+  RtoLinux (const RtoLinux &p);
+
+  virtual Time ComputeRto (Ptr<const RttEstimator> rtt) const;
+  virtual Ptr<RtoPolicy> Copy (void) const;
+
+private:
+  /**
+   * \brief Set the floor of the variation term
+   * \param minRttVar the floor of the variation term
+   */
+  void SetMinRttVar (Time minRttVar);
+
+  /**
+   * \brief Get the floor of the variation term
+   * \return the floor of the variation term
+   */
+  Time GetMinRttVar (void) const;
+
+  Time m_minRttVar; //!< Floor of the variation term
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief An Eifel-style retransmission timeout
+ *
+ * In the spirit of the Eifel retransmission timer (R. Ludwig and
+ * K. Sklower, "The Eifel retransmission timer", ACM CCR 30(3), 2000),
+ * the variation term does not grow when the RTT falls.  The policy keeps
+ * its own variation, fed by the samples: a sample above the estimate
+ * moves it by VariationGain toward its deviation, a sample below the
+ * estimate leaves it alone, whereas |SRTT - R'| in RFC 6298 inflates the
+ * RTO on either side.  Then
+ * RTO = SRTT + max (G, K * RTTVAR'), and never less than the last sample
+ * plus twice the clock granularity, so that a sample just above SRTT does
+ * not expire the timer.
+ *
+ * Before the first sample the variation of the estimator is used.
+ */
+class RtoEifel : public RtoPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RtoEifel ();
+  /**
+   * \brief Copy constructor
+   * \param p the object to copy
+   */
+  RtoEifel (const RtoEifel &p);
+
+  virtual Time ComputeRto (Ptr<const RttEstimator> rtt) const;
+  virtual Ptr<RtoPolicy> Copy (void) const;
+  virtual void AddSample (Time sample, Time estimate);
+  virtual void Reset (void);
+
+private:
+  /**
+   * \brief Set the multiplier of the RTT variation
+   * \param k the multiplier
+   */
+  void SetK (uint32_t k);
+
+  /**
+   * \brief Get the multiplier of the RTT variation
+   * \return the multiplier
+   */
+  uint32_t GetK (void) const;
+
+  /**
+   * \brief Set the gain of the variation
+   * \param gain the gain, 0 <= gain <= 1
+   */
+  void SetVariationGain (double gain);
+
+  /**
+   * \brief Get the gain of the variation
+   * \return the gain
+   */
+  double GetVariationGain (void) const;
+
+  uint32_t m_k;               //!< Multiplier of the RTT variation
+  double   m_gain;            //!< Gain of the variation
+  Time     m_variation;       //!< Variation, fed by the samples above the estimate
+  Time     m_lastSample;      //!< Last RTT sample
+  bool     m_sampled {false}; //!< A sample was taken since the last reset
+};
+
+} // namespace ns3
+
+#endif /* RTO_POLICY_H */
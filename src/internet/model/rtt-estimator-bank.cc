@@ -0,0 +1,247 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+// Structure-of-arrays replay of the Jacobson/Karels integer estimator
+// over many independent flows
+
+#if defined (__AVX2__) || defined (__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+
+#include "rtt-estimator-bank.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RttEstimatorBank");
+
+#if defined (__AVX2__)
+
+// Arithmetic right shift of 64 bit lanes, which AVX2 lacks: complement
+// the negative lanes, shift them logically, and complement them back.
+static inline __m256i
+Sra64 (__m256i x, __m128i count)
+{
+  __m256i sign = _mm256_cmpgt_epi64 (_mm256_setzero_si256 (), x);
+  return _mm256_xor_si256 (_mm256_srl_epi64 (_mm256_xor_si256 (x, sign), count), sign);
+}
+
+// Four flows at a time
+static std::size_t
+UpdateAvx2 (const int64_t *samples, int64_t *srtt, int64_t *rttvar, int64_t *n,
+            std::size_t nFlows, uint32_t rttShift, uint32_t variationShift)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m128i rs = _mm_cvtsi32_si128 (static_cast<int> (rttShift));
+  const __m128i vs = _mm_cvtsi32_si128 (static_cast<int> (variationShift));
+  const __m128i one = _mm_cvtsi32_si128 (1);
+  std::size_t i = 0;
+  for (; i + 4 <= nFlows; i += 4)
+    {
+      __m256i meas = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (samples + i));
+      __m256i s = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (srtt + i));
+      __m256i v = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (rttvar + i));
+      __m256i c = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (n + i));
+
+      __m256i valid = _mm256_cmpgt_epi64 (meas, zero);
+      __m256i first = _mm256_and_si256 (valid, _mm256_cmpeq_epi64 (c, zero));
+
+      // Jacobson/Karels paper appendix A.2
+      __m256i delta = _mm256_sub_epi64 (meas, s);
+      __m256i newS = Sra64 (_mm256_add_epi64 (_mm256_sll_epi64 (s, rs), delta), rs);
+      __m256i sign = _mm256_cmpgt_epi64 (zero, delta);
+      delta = _mm256_sub_epi64 (_mm256_xor_si256 (delta, sign), sign);
+      delta = _mm256_sub_epi64 (delta, v);
+      __m256i newV = Sra64 (_mm256_add_epi64 (_mm256_sll_epi64 (v, vs), delta), vs);
+
+      // First sample: estimate to current, variation to current / 2
+      newS = _mm256_blendv_epi8 (newS, meas, first);
+      newV = _mm256_blendv_epi8 (newV, Sra64 (meas, one), first);
+
+      s = _mm256_blendv_epi8 (s, newS, valid);
+      v = _mm256_blendv_epi8 (v, newV, valid);
+      c = _mm256_sub_epi64 (c, valid);
+
+      _mm256_storeu_si256 (reinterpret_cast<__m256i *> (srtt + i), s);
+      _mm256_storeu_si256 (reinterpret_cast<__m256i *> (rttvar + i), v);
+      _mm256_storeu_si256 (reinterpret_cast<__m256i *> (n + i), c);
+    }
+  return i;
+}
+
+#elif defined (__SSE4_2__)
+
+// Arithmetic right shift of 64 bit lanes, see the AVX2 version
+static inline __m128i
+Sra64 (__m128i x, __m128i count)
+{
+  __m128i sign = _mm_cmpgt_epi64 (_mm_setzero_si128 (), x);
+  return _mm_xor_si128 (_mm_srl_epi64 (_mm_xor_si128 (x, sign), count), sign);
+}
+
+// Two flows at a time
+static std::size_t
+UpdateSse42 (const int64_t *samples, int64_t *srtt, int64_t *rttvar, int64_t *n,
+             std::size_t nFlows, uint32_t rttShift, uint32_t variationShift)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i rs = _mm_cvtsi32_si128 (static_cast<int> (rttShift));
+  const __m128i vs = _mm_cvtsi32_si128 (static_cast<int> (variationShift));
+  const __m128i one = _mm_cvtsi32_si128 (1);
+  std::size_t i = 0;
+  for (; i + 2 <= nFlows; i += 2)
+    {
+      __m128i meas = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (samples + i));
+      __m128i s = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (srtt + i));
+      __m128i v = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (rttvar + i));
+      __m128i c = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (n + i));
+
+      __m128i valid = _mm_cmpgt_epi64 (meas, zero);
+      __m128i first = _mm_and_si128 (valid, _mm_cmpeq_epi64 (c, zero));
+
+      __m128i delta = _mm_sub_epi64 (meas, s);
+      __m128i newS = Sra64 (_mm_add_epi64 (_mm_sll_epi64 (s, rs), delta), rs);
+      __m128i sign = _mm_cmpgt_epi64 (zero, delta);
+      delta = _mm_sub_epi64 (_mm_xor_si128 (delta, sign), sign);
+      delta = _mm_sub_epi64 (delta, v);
+      __m128i newV = Sra64 (_mm_add_epi64 (_mm_sll_epi64 (v, vs), delta), vs);
+
+      newS = _mm_blendv_epi8 (newS, meas, first);
+      newV = _mm_blendv_epi8 (newV, Sra64 (meas, one), first);
+
+      s = _mm_blendv_epi8 (s, newS, valid);
+      v = _mm_blendv_epi8 (v, newV, valid);
+      c = _mm_sub_epi64 (c, valid);
+
+      _mm_storeu_si128 (reinterpret_cast<__m128i *> (srtt + i), s);
+      _mm_storeu_si128 (reinterpret_cast<__m128i *> (rttvar + i), v);
+      _mm_storeu_si128 (reinterpret_cast<__m128i *> (n + i), c);
+    }
+  return i;
+}
+
+#endif
+
+RttEstimatorBank::RttEstimatorBank (std::size_t nFlows, uint32_t rttShift,
+                                    uint32_t variationShift, Time initialEstimate)
+  : m_rttShift (rttShift),
+    m_variationShift (variationShift),
+    m_initialEstimate (initialEstimate.GetInteger ()),
+    m_estimatedRtt (nFlows, m_initialEstimate),
+    m_estimatedVariation (nFlows, 0),
+    m_nSamples (nFlows, 0)
+{
+  NS_LOG_FUNCTION (this << nFlows << rttShift << variationShift << initialEstimate);
+  NS_ASSERT_MSG (rttShift > 0 && rttShift < 32 && variationShift > 0 && variationShift < 32,
+                 "Shifts must be in [1, 31]");
+}
+
+void
+RttEstimatorBank::Update (const int64_t *samples)
+{
+  NS_LOG_FUNCTION (this);
+  std::size_t done = 0;
+#if defined (__AVX2__)
+  done = UpdateAvx2 (samples, m_estimatedRtt.data (), m_estimatedVariation.data (),
+                     m_nSamples.data (), GetN (), m_rttShift, m_variationShift);
+#elif defined (__SSE4_2__)
+  done = UpdateSse42 (samples, m_estimatedRtt.data (), m_estimatedVariation.data (),
+                      m_nSamples.data (), GetN (), m_rttShift, m_variationShift);
+#endif
+  UpdateScalar (samples, done, GetN ());
+}
+
+void
+RttEstimatorBank::UpdateScalar (const int64_t *samples, std::size_t begin, std::size_t end)
+{
+  for (std::size_t i = begin; i < end; ++i)
+    {
+      int64_t meas = samples[i];
+      if (meas <= 0)
+        {
+          continue;
+        }
+      if (m_nSamples[i] == 0)
+        { // First sample
+          m_estimatedRtt[i] = meas;
+          m_estimatedVariation[i] = meas / 2;
+        }
+      else
+        { // Jacobson/Karels paper appendix A.2
+          int64_t delta = meas - m_estimatedRtt[i];
+          int64_t srtt = (m_estimatedRtt[i] << m_rttShift) + delta;
+          m_estimatedRtt[i] = srtt >> m_rttShift;
+          if (delta < 0)
+            {
+              delta = -delta;
+            }
+          delta -= m_estimatedVariation[i];
+          int64_t rttvar = m_estimatedVariation[i] << m_variationShift;
+          rttvar += delta;
+          m_estimatedVariation[i] = rttvar >> m_variationShift;
+        }
+      m_nSamples[i]++;
+    }
+}
+
+void
+RttEstimatorBank::Reset (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::fill (m_estimatedRtt.begin (), m_estimatedRtt.end (), m_initialEstimate);
+  std::fill (m_estimatedVariation.begin (), m_estimatedVariation.end (), 0);
+  std::fill (m_nSamples.begin (), m_nSamples.end (), 0);
+}
+
+const char *
+RttEstimatorBank::GetKernelName (void)
+{
+#if defined (__AVX2__)
+  return "avx2";
+#elif defined (__SSE4_2__)
+  return "sse4.2";
+#else
+  return "scalar";
+#endif
+}
+
+std::size_t
+RttEstimatorBank::GetN (void) const
+{
+  return m_estimatedRtt.size ();
+}
+
+Time
+RttEstimatorBank::GetEstimate (std::size_t flow) const
+{
+  return Time::From (m_estimatedRtt[flow]);
+}
+
+Time
+RttEstimatorBank::GetVariation (std::size_t flow) const
+{
+  return Time::From (m_estimatedVariation[flow]);
+}
+
+uint32_t
+RttEstimatorBank::GetNSamples (std::size_t flow) const
+{
+  return static_cast<uint32_t> (m_nSamples[flow]);
+}
+
+} // namespace ns3
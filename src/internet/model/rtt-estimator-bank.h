@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef RTT_ESTIMATOR_BANK_H
+#define RTT_ESTIMATOR_BANK_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief A bank of independent mean-deviation RTT estimators
+ *
+ * Offline replay helper that runs the integer (shift based) update of
+ * RttMeanDeviation over many independent flows at once.  The SRTT, RTTVAR
+ * and sample count of every flow are kept as a structure of arrays of
+ * int64_t lanes, expressed in Time integer units, so that the update can be
+ * vectorized.  AVX2 or SSE4.2 kernels are used when the compiler targets
+ * them, with a scalar fallback otherwise; all the kernels produce, for
+ * every flow, exactly the state that RttMeanDeviation::IntegerUpdate would
+ * produce for the same sample sequence.
+ *
+ * All the flows share the same gains, given as shifts (log base 2 of
+ * 1/alpha and 1/beta).
+ */
+class RttEstimatorBank
+{
+public:
+  /**
+   * \brief Constructor
+   * \param nFlows number of independent estimators in the bank
+   * \param rttShift log base 2 (1/alpha)
+   * \param variationShift log base 2 (1/beta)
+   * \param initialEstimate initial RTT estimate of every flow
+   */
+  RttEstimatorBank (std::size_t nFlows, uint32_t rttShift, uint32_t variationShift,
+                    Time initialEstimate = Seconds (1.0));
+
+  /**
+   * \brief Add one measurement per flow
+   *
+   * samples[i] is the RTT measured by flow i, in Time integer units (see
+   * Time::GetInteger ()).  Flows with a sample lower than or equal to zero
+   * did not get a measurement in this round and are left untouched.
+   *
+   * \param samples array of GetN () samples
+   */
+  void Update (const int64_t *samples);
+
+  /**
+   * \brief Resets every flow to its initial state.
+   */
+  void Reset (void);
+
+  /**
+   * \brief Get the name of the kernel compiled in
+   *
+   * The kernel is chosen when this file is compiled: "avx2", "sse4.2" or
+   * "scalar".  Flows past the last full group of lanes always go through
+   * the scalar code.
+   *
+   * \return the name of the kernel
+   */
+  static const char * GetKernelName (void);
+
+  /**
+   * \brief Get the number of flows in the bank
+   * \return the number of flows
+   */
+  std::size_t GetN (void) const;
+
+  /**
+   * \brief gets the RTT estimate of a flow.
+   * \param flow index of the flow
+   * \return The RTT estimate.
+   */
+  Time GetEstimate (std::size_t flow) const;
+
+  /**
+   * \brief gets the RTT estimate variation of a flow.
+   * \param flow index of the flow
+   * \return The RTT estimate variation.
+   */
+  Time GetVariation (std::size_t flow) const;
+
+  /**
+   * \brief gets the number of samples used in the estimates of a flow
+   * \param flow index of the flow
+   * \return the number of samples used in the estimates
+   */
+  uint32_t GetNSamples (std::size_t flow) const;
+
+private:
+  /**
+   * Scalar update of the flows in [begin, end), mirroring
+   * RttMeanDeviation::IntegerUpdate.
+   *
+   * \param samples array of samples, indexed by flow
+   * \param begin first flow to update
+   * \param end one past the last flow to update
+   */
+  void UpdateScalar (const int64_t *samples, std::size_t begin, std::size_t end);
+
+  uint32_t             m_rttShift;        //!< log base 2 (1/alpha)
+  uint32_t             m_variationShift;  //!< log base 2 (1/beta)
+  int64_t              m_initialEstimate; //!< Initial RTT estimate, in Time integer units
+  std::vector<int64_t> m_estimatedRtt;    //!< Current estimate of every flow
+  std::vector<int64_t> m_estimatedVariation; //!< Current estimate variation of every flow
+  std::vector<int64_t> m_nSamples;        //!< Number of samples of every flow
+};
+
+} // namespace ns3
+
+#endif /* RTT_ESTIMATOR_BANK_H */
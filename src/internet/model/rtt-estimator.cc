@@ -27,11 +27,15 @@
 
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 
 #include "rtt-estimator.h"
 #include "ns3/double.h"
 #include "ns3/boolean.h"
+#include "ns3/uinteger.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
 
 namespace ns3 {
 
@@ -42,6 +46,52 @@ NS_OBJECT_ENSURE_REGISTERED (RttEstimator);
 /// Tolerance used to check reciprocal of two numbers.
 static const double TOLERANCE = 1e-6;
 
+/// Number of fractional bits of the fixed-point gains.
+static const int GAIN_FRAC_BITS = 16;
+/// A gain of 1 in fixed point.
+static const int64_t GAIN_ONE = INT64_C (1) << GAIN_FRAC_BITS;
+/**
+ * \brief Fixed-point counterpart of CheckForReciprocalPowerOfTwo
+ * \param gain gain in Q.16 fixed point
+ * \return log base 2 (1/gain) if it is 1/32, 1/16, 1/8, 1/4 or 1/2, or zero
+ */
+static uint32_t
+ShiftOfFixedPointGain (int64_t gain)
+{
+  for (uint32_t shift = 1; shift <= 5; ++shift)
+    {
+      if (gain == (GAIN_ONE >> shift))
+        {
+          return shift;
+        }
+    }
+  return 0;
+}
+
+/**
+ * \brief Fixed-point step of a gain toward its configured value
+ *
+ * The step is rounded away from zero, so that the gain reaches the
+ * configured value exactly instead of stalling a few units short of it.
+ *
+ * \param distance configured gain minus gain in use, Q.16 fixed point
+ * \param decay fraction of the distance to recover, Q.16 fixed point
+ * \return the step to add to the gain in use
+ */
+static int64_t
+DecayStep (int64_t distance, int64_t decay)
+{
+  if (distance < 0)
+    {
+      return -((-distance * decay + GAIN_ONE - 1) >> GAIN_FRAC_BITS);
+    }
+  return (distance * decay + GAIN_ONE - 1) >> GAIN_FRAC_BITS;
+}
+
+/// Bound on the fixed-point RTT rate of change; beyond it every non-zero
+/// gain hits its bounds anyway, and products with the gains cannot overflow.
+static const int64_t RATE_MAX = INT64_C (1) << 40;
+
 TypeId 
 RttEstimator::GetTypeId (void)
 {
@@ -53,6 +103,24 @@ RttEstimator::GetTypeId (void)
                    TimeValue (Seconds (1.0)),
                    MakeTimeAccessor (&RttEstimator::m_initialEstimatedRtt),
                    MakeTimeChecker ())
+    .AddAttribute ("QuantileSketch",
+                   "Keep a sketch of the RTT samples to estimate their quantiles",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RttEstimator::SetQuantileSketch,
+                                        &RttEstimator::GetQuantileSketch),
+                   MakeBooleanChecker ())
+    .AddAttribute ("QuantileAccuracy",
+                   "Relative accuracy of the quantiles of the RTT samples",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&RttEstimator::SetQuantileAccuracy,
+                                       &RttEstimator::GetQuantileAccuracy),
+                   MakeDoubleChecker<double> (1e-6, 0.5))
+    .AddAttribute ("QuantileMaxBuckets",
+                   "Maximum number of buckets of the sketch of the RTT samples",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&RttEstimator::SetQuantileMaxBuckets,
+                                         &RttEstimator::GetQuantileMaxBuckets),
+                   MakeUintegerChecker<uint32_t> (1))
   ;
   return tid;
 }
@@ -88,9 +156,14 @@ RttEstimator::RttEstimator ()
 RttEstimator::RttEstimator (const RttEstimator& c)
   : Object (c),
     m_initialEstimatedRtt (c.m_initialEstimatedRtt),
+    m_quantileEnabled (c.m_quantileEnabled),
+    m_quantileAccuracy (c.m_quantileAccuracy),
+    m_quantileMaxBuckets (c.m_quantileMaxBuckets),
+    m_quantileSketch (c.m_quantileSketch),
     m_estimatedRtt (c.m_estimatedRtt),
     m_estimatedVariation (c.m_estimatedVariation),
-    m_nSamples (c.m_nSamples)
+    m_nSamples (c.m_nSamples),
+    prev_rtt (c.prev_rtt)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -113,6 +186,19 @@ void RttEstimator::Reset ()
   m_estimatedRtt = m_initialEstimatedRtt;
   m_estimatedVariation = Time (0);
   m_nSamples = 0;
+  m_quantileSketch.Clear ();
+}
+
+void
+RttEstimator::Seed (Time estimate, Time variation)
+{
+  NS_LOG_FUNCTION (this << estimate << variation);
+  if (m_nSamples > 0)
+    {
+      return;
+    }
+  m_estimatedRtt = estimate;
+  m_estimatedVariation = variation;
 }
 
 uint32_t 
@@ -121,6 +207,71 @@ RttEstimator::GetNSamples (void) const
   return m_nSamples;
 }
 
+Time
+RttEstimator::GetQuantile (double q) const
+{
+  return m_quantileSketch.GetQuantile (q);
+}
+
+void
+RttEstimator::SetQuantileSketch (bool enable)
+{
+  NS_LOG_FUNCTION (this << enable);
+  m_quantileEnabled = enable;
+  if (enable)
+    {
+      m_quantileSketch.Configure (m_quantileAccuracy, m_quantileMaxBuckets);
+    }
+  else
+    {
+      m_quantileSketch.Disable ();
+    }
+}
+
+bool
+RttEstimator::GetQuantileSketch (void) const
+{
+  return m_quantileEnabled;
+}
+
+void
+RttEstimator::SetQuantileAccuracy (double alpha)
+{
+  NS_LOG_FUNCTION (this << alpha);
+  m_quantileAccuracy = alpha;
+  SetQuantileSketch (m_quantileEnabled);
+}
+
+double
+RttEstimator::GetQuantileAccuracy (void) const
+{
+  return m_quantileAccuracy;
+}
+
+void
+RttEstimator::SetQuantileMaxBuckets (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  m_quantileMaxBuckets = n;
+  SetQuantileSketch (m_quantileEnabled);
+}
+
+uint32_t
+RttEstimator::GetQuantileMaxBuckets (void) const
+{
+  return m_quantileMaxBuckets;
+}
+
+void
+RttEstimator::MeasurementBatch (const Time *samples, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      Measurement (samples[i]);
+    }
+}
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 // Mean-Deviation Estimator
@@ -137,17 +288,63 @@ RttMeanDeviation::GetTypeId (void)
     .AddAttribute ("Alpha",
                    "Gain used in estimating the RTT, must be 0 <= alpha <= 1",
                    DoubleValue (0.125),
-                   MakeDoubleAccessor (&RttMeanDeviation::m_alpha),
+                   MakeDoubleAccessor (&RttMeanDeviation::SetAlpha,
+                                       &RttMeanDeviation::GetAlpha),
                    MakeDoubleChecker<double> (0, 1))
     .AddAttribute ("Beta",
                    "Gain used in estimating the RTT variation, must be 0 <= beta <= 1",
                    DoubleValue (0.25),
-                   MakeDoubleAccessor (&RttMeanDeviation::m_beta),
+                   MakeDoubleAccessor (&RttMeanDeviation::SetBeta,
+                                       &RttMeanDeviation::GetBeta),
                    MakeDoubleChecker<double> (0, 1))
     .AddAttribute ("Modified_RTT_Calc", "Use modified version of rtt calculation",
                    BooleanValue (false),
                    MakeBooleanAccessor (&RttMeanDeviation::modified_rtt_calc),
-                   MakeBooleanChecker ());
+                   MakeBooleanChecker ())
+    .AddAttribute ("FixedPoint",
+                   "Run the modified version of rtt calculation in fixed-point arithmetic",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RttMeanDeviation::m_fixedPoint),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MinAlpha",
+                   "Lower bound of the RTT gain in use with the modified rtt calculation",
+                   DoubleValue (1.0 / 64),
+                   MakeDoubleAccessor (&RttMeanDeviation::SetMinAlpha,
+                                       &RttMeanDeviation::GetMinAlpha),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("MaxAlpha",
+                   "Upper bound of the RTT gain in use with the modified rtt calculation",
+                   DoubleValue (1),
+                   MakeDoubleAccessor (&RttMeanDeviation::SetMaxAlpha,
+                                       &RttMeanDeviation::GetMaxAlpha),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("MinBeta",
+                   "Lower bound of the RTT variation gain in use with the modified rtt calculation",
+                   DoubleValue (1.0 / 64),
+                   MakeDoubleAccessor (&RttMeanDeviation::SetMinBeta,
+                                       &RttMeanDeviation::GetMinBeta),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("MaxBeta",
+                   "Upper bound of the RTT variation gain in use with the modified rtt calculation",
+                   DoubleValue (1),
+                   MakeDoubleAccessor (&RttMeanDeviation::SetMaxBeta,
+                                       &RttMeanDeviation::GetMaxBeta),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("GainDecay",
+                   "Fraction of the distance between the gains in use and Alpha and Beta "
+                   "recovered on every sample with the modified rtt calculation",
+                   DoubleValue (1.0 / 32),
+                   MakeDoubleAccessor (&RttMeanDeviation::SetGainDecay,
+                                       &RttMeanDeviation::GetGainDecay),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddTraceSource ("CurrentAlpha",
+                     "Gain in use in estimating the RTT",
+                     MakeTraceSourceAccessor (&RttMeanDeviation::m_currentAlpha),
+                     "ns3::TracedValueCallback::Double")
+    .AddTraceSource ("CurrentBeta",
+                     "Gain in use in estimating the RTT variation",
+                     MakeTraceSourceAccessor (&RttMeanDeviation::m_currentBeta),
+                     "ns3::TracedValueCallback::Double")
   ;
   return tid;
 }
@@ -158,7 +355,18 @@ RttMeanDeviation::RttMeanDeviation()
 }
 
 RttMeanDeviation::RttMeanDeviation (const RttMeanDeviation& c)
-  : RttEstimator (c), m_alpha (c.m_alpha), m_beta (c.m_beta)
+  : RttEstimator (c), m_alpha (c.m_alpha), m_beta (c.m_beta),
+    m_currentAlpha (c.m_currentAlpha), m_currentBeta (c.m_currentBeta),
+    m_minAlpha (c.m_minAlpha), m_maxAlpha (c.m_maxAlpha),
+    m_minBeta (c.m_minBeta), m_maxBeta (c.m_maxBeta),
+    m_gainDecay (c.m_gainDecay),
+    m_rttShift (c.m_rttShift), m_variationShift (c.m_variationShift),
+    m_alphaQ (c.m_alphaQ), m_betaQ (c.m_betaQ),
+    m_baseAlphaQ (c.m_baseAlphaQ), m_baseBetaQ (c.m_baseBetaQ),
+    m_minAlphaQ (c.m_minAlphaQ), m_maxAlphaQ (c.m_maxAlphaQ),
+    m_minBetaQ (c.m_minBetaQ), m_maxBetaQ (c.m_maxBetaQ),
+    m_gainDecayQ (c.m_gainDecayQ),
+    modified_rtt_calc (c.modified_rtt_calc), m_fixedPoint (c.m_fixedPoint)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -169,34 +377,160 @@ RttMeanDeviation::GetInstanceTypeId (void) const
   return GetTypeId ();
 }
 
+void
+RttMeanDeviation::SetAlpha (double alpha)
+{
+  NS_LOG_FUNCTION (this << alpha);
+  m_alpha = alpha;
+  m_baseAlphaQ = std::llround (m_alpha * GAIN_ONE);
+  SetCurrentAlpha (m_alpha);
+}
+
+double
+RttMeanDeviation::GetAlpha (void) const
+{
+  return m_alpha;
+}
+
+void
+RttMeanDeviation::SetBeta (double beta)
+{
+  NS_LOG_FUNCTION (this << beta);
+  m_beta = beta;
+  m_baseBetaQ = std::llround (m_beta * GAIN_ONE);
+  SetCurrentBeta (m_beta);
+}
+
+double
+RttMeanDeviation::GetBeta (void) const
+{
+  return m_beta;
+}
+
+double
+RttMeanDeviation::GetCurrentAlpha (void) const
+{
+  return m_currentAlpha;
+}
+
+double
+RttMeanDeviation::GetCurrentBeta (void) const
+{
+  return m_currentBeta;
+}
+
+void
+RttMeanDeviation::SetCurrentAlpha (double alpha)
+{
+  m_currentAlpha = alpha;
+  m_rttShift = CheckForReciprocalPowerOfTwo (alpha);
+  m_alphaQ = std::llround (alpha * GAIN_ONE);
+}
+
+void
+RttMeanDeviation::SetCurrentBeta (double beta)
+{
+  m_currentBeta = beta;
+  m_variationShift = CheckForReciprocalPowerOfTwo (beta);
+  m_betaQ = std::llround (beta * GAIN_ONE);
+}
+
+void
+RttMeanDeviation::UpdateFixedPointLimits (void)
+{
+  m_minAlphaQ = std::llround (m_minAlpha * GAIN_ONE);
+  m_maxAlphaQ = std::llround (m_maxAlpha * GAIN_ONE);
+  m_minBetaQ = std::llround (m_minBeta * GAIN_ONE);
+  m_maxBetaQ = std::llround (m_maxBeta * GAIN_ONE);
+  m_gainDecayQ = std::llround (m_gainDecay * GAIN_ONE);
+}
+
+void
+RttMeanDeviation::SetMinAlpha (double v)
+{
+  m_minAlpha = v;
+  UpdateFixedPointLimits ();
+}
+
+double
+RttMeanDeviation::GetMinAlpha (void) const
+{
+  return m_minAlpha;
+}
+
+void
+RttMeanDeviation::SetMaxAlpha (double v)
+{
+  m_maxAlpha = v;
+  UpdateFixedPointLimits ();
+}
+
+double
+RttMeanDeviation::GetMaxAlpha (void) const
+{
+  return m_maxAlpha;
+}
+
+void
+RttMeanDeviation::SetMinBeta (double v)
+{
+  m_minBeta = v;
+  UpdateFixedPointLimits ();
+}
+
+double
+RttMeanDeviation::GetMinBeta (void) const
+{
+  return m_minBeta;
+}
+
+void
+RttMeanDeviation::SetMaxBeta (double v)
+{
+  m_maxBeta = v;
+  UpdateFixedPointLimits ();
+}
+
+double
+RttMeanDeviation::GetMaxBeta (void) const
+{
+  return m_maxBeta;
+}
+
+void
+RttMeanDeviation::SetGainDecay (double v)
+{
+  m_gainDecay = v;
+  UpdateFixedPointLimits ();
+}
+
+double
+RttMeanDeviation::GetGainDecay (void) const
+{
+  return m_gainDecay;
+}
+
 uint32_t
-RttMeanDeviation::CheckForReciprocalPowerOfTwo (double val) const
+RttMeanDeviation::CheckForReciprocalPowerOfTwo (double val)
 {
-  NS_LOG_FUNCTION (this << val);
   if (val < TOLERANCE)
     {
       return 0;
     }
   // supports 1/32, 1/16, 1/8, 1/4, 1/2
-  if (std::abs (1/val - 8) < TOLERANCE)
-    {
-      return 3;
-    }
-  if (std::abs (1/val - 4) < TOLERANCE)
-    {
-      return 2;
-    }
-  if (std::abs (1/val - 32) < TOLERANCE)
-    {
-      return 5;
-    }
-  if (std::abs (1/val - 16) < TOLERANCE)
+  // Only the power of two nearest to val can be within the tolerance, so
+  // pick it from the binary exponent (val = mantissa * 2^exp, with
+  // 0.5 <= mantissa < 1) and check that one alone
+  int exp;
+  double mantissa = std::frexp (val, &exp);
+  int shift = (mantissa < 0.75) ? 1 - exp : -exp;
+  if (shift < 1 || shift > 5)
     {
-      return 4;
+      return 0;
     }
-  if (std::abs (1/val - 2) < TOLERANCE)
+  if (std::abs (1/val - (1 << shift)) < TOLERANCE)
     {
-      return 1;
+      return static_cast<uint32_t> (shift);
     }
   return 0;
 }
@@ -211,12 +545,12 @@ RttMeanDeviation::FloatingPointUpdate (Time m)
 
   // SRTT <- (1 - alpha) * SRTT + alpha *  R'
   Time err (m - m_estimatedRtt);
-  double gErr = err.ToDouble (Time::S) * m_alpha;
+  double gErr = err.ToDouble (Time::S) * m_currentAlpha.Get ();
   m_estimatedRtt += Time::FromDouble (gErr, Time::S);
 
   // RTTVAR <- (1 - beta) * RTTVAR + beta * |SRTT - R'|
   Time difference = Abs (err) - m_estimatedVariation;
-  m_estimatedVariation += difference * m_beta;
+  m_estimatedVariation += difference * m_currentBeta.Get ();
   return;
 }
 
@@ -240,29 +574,138 @@ RttMeanDeviation::IntegerUpdate (Time m, uint32_t rttShift, uint32_t variationSh
   return;
 }
 
+void
+RttMeanDeviation::FixedPointModifiedUpdate (Time m)
+{
+  NS_LOG_FUNCTION (this << m);
+  int64_t meas = m.GetInteger ();
+  int64_t prev = prev_rtt.GetInteger ();
+  int64_t alpha = m_alphaQ;
+  int64_t beta = m_betaQ;
+  if (prev > 0)
+    {
+      // rate of change = (curr_rtt - prev_rtt) / prev_rtt, in Q.16
+      int64_t rate = ((meas - prev) * GAIN_ONE) / prev;
+      rate = std::min (std::max (rate, -RATE_MAX), RATE_MAX);
+      if (rate != 0)
+        {
+          // alpha *= (1 + rate), beta *= (1 - rate), both rounded half
+          // up: alpha + floor (y + 1/2) and beta - ceil (y - 1/2)
+          alpha += (alpha * rate + GAIN_ONE / 2) >> GAIN_FRAC_BITS;
+          beta -= (beta * rate + GAIN_ONE / 2 - 1) >> GAIN_FRAC_BITS;
+        }
+    }
+  if (m_gainDecayQ)
+    {
+      // Clamp first, so that the products below cannot overflow
+      alpha = std::min (std::max (alpha, m_minAlphaQ), m_maxAlphaQ);
+      beta = std::min (std::max (beta, m_minBetaQ), m_maxBetaQ);
+      alpha += DecayStep (m_baseAlphaQ - alpha, m_gainDecayQ);
+      beta += DecayStep (m_baseBetaQ - beta, m_gainDecayQ);
+    }
+  alpha = std::min (std::max (alpha, m_minAlphaQ), m_maxAlphaQ);
+  beta = std::min (std::max (beta, m_minBetaQ), m_maxBetaQ);
+  if (alpha != m_alphaQ)
+    {
+      m_alphaQ = alpha;
+      m_rttShift = ShiftOfFixedPointGain (alpha);
+      m_currentAlpha = static_cast<double> (alpha) / GAIN_ONE;
+    }
+  if (beta != m_betaQ)
+    {
+      m_betaQ = beta;
+      m_variationShift = ShiftOfFixedPointGain (beta);
+      m_currentBeta = static_cast<double> (beta) / GAIN_ONE;
+    }
+
+  // SRTT <- SRTT + alpha * (R' - SRTT)
+  int64_t delta = meas - m_estimatedRtt.GetInteger ();
+  m_estimatedRtt = Time::From (m_estimatedRtt.GetInteger () + ((delta * m_alphaQ) >> GAIN_FRAC_BITS));
+
+  // RTTVAR <- RTTVAR + beta * (|SRTT - R'| - RTTVAR)
+  if (delta < 0)
+    {
+      delta = -delta;
+    }
+  delta -= m_estimatedVariation.GetInteger ();
+  m_estimatedVariation = Time::From (m_estimatedVariation.GetInteger () + ((delta * m_betaQ) >> GAIN_FRAC_BITS));
+}
+
+void
+RttMeanDeviation::AdaptGains (Time m)
+{
+  double alpha = m_currentAlpha;
+  double beta = m_currentBeta;
+  if (prev_rtt.IsStrictlyPositive ())
+    {
+      double curr_rtt = m.GetDouble();
+      double p_rtt = prev_rtt.GetDouble();
+      double rtt_rate_of_change = (curr_rtt - p_rtt) / p_rtt;
+      alpha = alpha * (1 + rtt_rate_of_change);
+      beta = beta * (1 - rtt_rate_of_change);
+    }
+  if (m_gainDecay > 0)
+    {
+      // Clamp first, as FixedPointModifiedUpdate () does, so that a gain
+      // thrown past its bounds still moves toward Alpha and Beta
+      alpha = std::min (std::max (alpha, m_minAlpha), m_maxAlpha);
+      beta = std::min (std::max (beta, m_minBeta), m_maxBeta);
+      alpha += m_gainDecay * (m_alpha - alpha);
+      beta += m_gainDecay * (m_beta - beta);
+    }
+  alpha = std::min (std::max (alpha, m_minAlpha), m_maxAlpha);
+  beta = std::min (std::max (beta, m_minBeta), m_maxBeta);
+
+  // Only classify the gains again when they moved
+  if (alpha != m_currentAlpha)
+    {
+      SetCurrentAlpha (alpha);
+    }
+  if (beta != m_currentBeta)
+    {
+      SetCurrentBeta (beta);
+    }
+}
+
 void 
 RttMeanDeviation::Measurement (Time m)
 {
   NS_LOG_FUNCTION (this << m);
-  if (m_nSamples)
+  DoMeasurement (m);
+}
+
+void
+RttMeanDeviation::MeasurementBatch (const Time *samples, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      DoMeasurement (samples[i]);
+    }
+}
+
+void
+RttMeanDeviation::DoMeasurement (Time m)
+{
+  RecordQuantileSample (m);
+  if (m_nSamples && modified_rtt_calc && m_fixedPoint)
+    {
+      FixedPointModifiedUpdate (m);
+    }
+  else if (m_nSamples)
     { 
-      if (modified_rtt_calc) {
-        double curr_rtt = m.GetDouble();
-        double p_rtt = prev_rtt.GetDouble();
-        double rtt_rate_of_change = (curr_rtt - p_rtt) / p_rtt;
-        m_alpha = m_alpha * (1 + rtt_rate_of_change);
-        m_beta = m_beta * (1 - rtt_rate_of_change); 
-      }
+      if (modified_rtt_calc)
+        {
+          AdaptGains (m);
+        }
 
       // If both alpha and beta are reciprocal powers of two, updating can
       // be done with integer arithmetic according to Jacobson/Karels paper.
       // If not, since class Time only supports integer multiplication,
       // must convert Time to floating point and back again
-      uint32_t rttShift = CheckForReciprocalPowerOfTwo (m_alpha);
-      uint32_t variationShift = CheckForReciprocalPowerOfTwo (m_beta);
-      if (rttShift && variationShift)
+      if (m_rttShift && m_variationShift)
         {
-          IntegerUpdate (m, rttShift, variationShift);
+          IntegerUpdate (m, m_rttShift, m_variationShift);
         }
       else
         {
@@ -291,6 +734,374 @@ RttMeanDeviation::Reset ()
 { 
   NS_LOG_FUNCTION (this);
   RttEstimator::Reset ();
+  SetCurrentAlpha (m_alpha);
+  SetCurrentBeta (m_beta);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Linux Mean-Deviation Estimator
+
+NS_OBJECT_ENSURE_REGISTERED (RttLinuxMeanDeviation);
+
+TypeId
+RttLinuxMeanDeviation::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RttLinuxMeanDeviation")
+    .SetParent<RttEstimator> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RttLinuxMeanDeviation> ()
+    .AddAttribute ("MinRttVar",
+                   "Lower bound of the RTT variation used for the RTO (tcp_rto_min)",
+                   TimeValue (MilliSeconds (200)),
+                   MakeTimeAccessor (&RttLinuxMeanDeviation::m_minRttVar),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+RttLinuxMeanDeviation::RttLinuxMeanDeviation ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RttLinuxMeanDeviation::RttLinuxMeanDeviation (const RttLinuxMeanDeviation& c)
+  : RttEstimator (c), m_minRttVar (c.m_minRttVar),
+    m_srtt (c.m_srtt), m_mdev (c.m_mdev), m_mdevMax (c.m_mdevMax),
+    m_rttVar (c.m_rttVar), m_roundStart (c.m_roundStart)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+RttLinuxMeanDeviation::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
 }
 
+void
+RttLinuxMeanDeviation::Measurement (Time measure)
+{
+  NS_LOG_FUNCTION (this << measure);
+  RecordQuantileSample (measure);
+  int64_t m = measure.GetInteger ();
+  int64_t minRttVar = m_minRttVar.GetInteger ();
+  int64_t srtt = m_srtt;
+  Time now = Simulator::Now ();
+
+  if (srtt != 0)
+    {
+      m -= (srtt >> 3);           // m is now the error in the estimate
+      srtt += m;                  // srtt = 7/8 srtt + 1/8 new
+      if (m < 0)
+        {
+          m = -m;
+          m -= (m_mdev >> 2);
+          // A sample below the estimate pulls mdev down or up at 1/32
+          if (m > 0)
+            {
+              m >>= 3;
+            }
+        }
+      else
+        {
+          m -= (m_mdev >> 2);
+        }
+      m_mdev += m;                // mdev = 3/4 mdev + 1/4 new
+      if (m_mdev > m_mdevMax)
+        {
+          m_mdevMax = m_mdev;
+          if (m_mdevMax > m_rttVar)
+            {
+              m_rttVar = m_mdevMax;
+            }
+        }
+      if (now - measure > m_roundStart)
+        {
+          // End of the round: let rttvar decay toward mdev_max
+          if (m_mdevMax < m_rttVar)
+            {
+              m_rttVar -= (m_rttVar - m_mdevMax) >> 2;
+            }
+          m_roundStart = now;
+          m_mdevMax = minRttVar;
+        }
+    }
+  else
+    { // First sample
+      srtt = m << 3;
+      m_mdev = m << 1;            // RTO = 3 * RTT
+      m_rttVar = std::max (m_mdev, minRttVar);
+      m_mdevMax = m_rttVar;
+      m_roundStart = now;
+    }
+  m_srtt = std::max<int64_t> (1, srtt);
+
+  m_estimatedRtt = Time::From (m_srtt >> 3);
+  m_estimatedVariation = Time::From (m_rttVar >> 2);
+  m_nSamples++;
+  prev_rtt = measure;
+}
+
+Ptr<RttEstimator>
+RttLinuxMeanDeviation::Copy () const
+{
+  NS_LOG_FUNCTION (this);
+  return CopyObject<RttLinuxMeanDeviation> (this);
+}
+
+void
+RttLinuxMeanDeviation::Reset ()
+{
+  NS_LOG_FUNCTION (this);
+  RttEstimator::Reset ();
+  m_srtt = 0;
+  m_mdev = 0;
+  m_mdevMax = 0;
+  m_rttVar = 0;
+  m_roundStart = Time (0);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Kalman filter Estimator
+
+NS_OBJECT_ENSURE_REGISTERED (RttKalman);
+
+TypeId
+RttKalman::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RttKalman")
+    .SetParent<RttEstimator> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RttKalman> ()
+    .AddAttribute ("MeasurementNoiseGain",
+                   "Gain used in estimating the measurement noise",
+                   DoubleValue (0.125),
+                   MakeDoubleAccessor (&RttKalman::m_measurementNoiseGain),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("ProcessNoiseGain",
+                   "Gain used in estimating the mean of the innovations, "
+                   "from which the process noise is derived",
+                   DoubleValue (0.0625),
+                   MakeDoubleAccessor (&RttKalman::m_processNoiseGain),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("OutlierThreshold",
+                   "Innovations are clipped to this many predicted standard deviations",
+                   DoubleValue (3.0),
+                   MakeDoubleAccessor (&RttKalman::m_outlierThreshold),
+                   MakeDoubleChecker<double> (0))
+  ;
+  return tid;
+}
+
+RttKalman::RttKalman ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RttKalman::RttKalman (const RttKalman& c)
+  : RttEstimator (c),
+    m_measurementNoiseGain (c.m_measurementNoiseGain),
+    m_processNoiseGain (c.m_processNoiseGain),
+    m_outlierThreshold (c.m_outlierThreshold),
+    m_x (c.m_x), m_p (c.m_p), m_q (c.m_q), m_r (c.m_r), m_bias (c.m_bias)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+RttKalman::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+RttKalman::Measurement (Time measure)
+{
+  NS_LOG_FUNCTION (this << measure);
+  RecordQuantileSample (measure);
+  double z = static_cast<double> (measure.GetInteger ());
+
+  if (m_nSamples)
+    {
+      double prior = m_p + m_q;              // Predicted variance of x
+      double s = prior + m_r;                // Predicted variance of the innovation
+      double limit = m_outlierThreshold * std::sqrt (s);
+      double e = std::min (std::max (z - m_x, -limit), limit);
+      double k = prior / s;
+      m_x += k * e;
+      m_p = (1 - k) * prior;
+
+      // A persistent bias of the innovations means x lags: raise Q
+      m_bias += m_processNoiseGain * (e - m_bias);
+      m_q = m_bias * m_bias;
+      double d = e - m_bias;
+      m_r += m_measurementNoiseGain * (std::max (d * d - prior, 0.0) - m_r);
+    }
+  else
+    { // First sample: variation of z / 2, as RFC 6298
+      m_x = z;
+      m_p = z * z / 8;
+      m_r = z * z / 8;
+      m_q = 0;
+      m_bias = 0;
+    }
+
+  m_estimatedRtt = Time::From (std::max<int64_t> (1, std::llround (m_x)));
+  m_estimatedVariation = Time::From (std::llround (std::sqrt (m_p + m_q + m_r)));
+  m_nSamples++;
+  prev_rtt = measure;
+}
+
+Ptr<RttEstimator>
+RttKalman::Copy () const
+{
+  NS_LOG_FUNCTION (this);
+  return CopyObject<RttKalman> (this);
+}
+
+void
+RttKalman::Reset ()
+{
+  NS_LOG_FUNCTION (this);
+  RttEstimator::Reset ();
+  m_x = 0;
+  m_p = 0;
+  m_q = 0;
+  m_r = 0;
+  m_bias = 0;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Holt linear trend Estimator
+
+NS_OBJECT_ENSURE_REGISTERED (RttHolt);
+
+TypeId
+RttHolt::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RttHolt")
+    .SetParent<RttEstimator> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RttHolt> ()
+    .AddAttribute ("LevelGain",
+                   "Gain used in estimating the level of the RTT",
+                   DoubleValue (0.125),
+                   MakeDoubleAccessor (&RttHolt::m_levelGain),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("TrendGain",
+                   "Gain used in estimating the trend of the RTT",
+                   DoubleValue (0.125),
+                   MakeDoubleAccessor (&RttHolt::m_trendGain),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("VariationGain",
+                   "Gain used in estimating the RTT variation",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&RttHolt::m_variationGain),
+                   MakeDoubleChecker<double> (0, 1))
+  ;
+  return tid;
+}
+
+RttHolt::RttHolt ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RttHolt::RttHolt (const RttHolt& c)
+  : RttEstimator (c),
+    m_levelGain (c.m_levelGain),
+    m_trendGain (c.m_trendGain),
+    m_variationGain (c.m_variationGain),
+    m_level (c.m_level), m_trend (c.m_trend), m_variation (c.m_variation),
+    m_lastSample (c.m_lastSample),
+    m_roundLevel (c.m_roundLevel), m_roundStart (c.m_roundStart)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+RttHolt::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+RttHolt::Measurement (Time measure)
+{
+  NS_LOG_FUNCTION (this << measure);
+  RecordQuantileSample (measure);
+  double z = static_cast<double> (measure.GetInteger ());
+  Time now = Simulator::Now ();
+
+  if (m_nSamples)
+    {
+      double dt = static_cast<double> ((now - m_lastSample).GetInteger ());
+      double forecast = std::max (m_level + m_trend * dt, 0.0);
+      double e = z - forecast;
+      m_level = forecast + m_levelGain * e;
+      m_variation += m_variationGain * (std::fabs (e) - m_variation);
+
+      // The slope between two samples close in time is mostly noise:
+      // measure it once per RTT
+      double span = static_cast<double> ((now - m_roundStart).GetInteger ());
+      if (span >= m_level)
+        {
+          m_trend += m_trendGain * ((m_level - m_roundLevel) / span - m_trend);
+          m_roundLevel = m_level;
+          m_roundStart = now;
+        }
+    }
+  else
+    { // First sample
+      m_level = z;
+      m_trend = 0;
+      m_variation = z / 2;
+      m_roundLevel = z;
+      m_roundStart = now;
+    }
+  m_lastSample = now;
+
+  // Project a growing RTT one RTT ahead
+  double estimate = m_level + std::max (m_trend, 0.0) * m_level;
+  m_estimatedRtt = Time::From (std::max<int64_t> (1, std::llround (estimate)));
+  m_estimatedVariation = Time::From (std::llround (m_variation));
+  m_nSamples++;
+  prev_rtt = measure;
+}
+
+Ptr<RttEstimator>
+RttHolt::Copy () const
+{
+  NS_LOG_FUNCTION (this);
+  return CopyObject<RttHolt> (this);
+}
+
+void
+RttHolt::Reset ()
+{
+  NS_LOG_FUNCTION (this);
+  RttEstimator::Reset ();
+  m_level = 0;
+  m_trend = 0;
+  m_variation = 0;
+  m_lastSample = Time (0);
+  m_roundLevel = 0;
+  m_roundStart = Time (0);
+}
+
+double
+RttHolt::GetTrend (void) const
+{
+  return m_trend;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Mean-Deviation Estimator with compile-time gains
+
+NS_OBJECT_ENSURE_REGISTERED (RttMeanDeviationRfc6298);
+
 } //namespace ns3
@@ -25,8 +25,13 @@
 #ifndef RTT_ESTIMATOR_H
 #define RTT_ESTIMATOR_H
 
+#include <cstddef>
+#include <string>
+
 #include "ns3/nstime.h"
 #include "ns3/object.h"
+#include "ns3/traced-value.h"
+#include "rtt-quantile-sketch.h"
 
 namespace ns3 {
 
@@ -65,6 +70,19 @@ public:
    */
   virtual void  Measurement (Time t) = 0;
 
+  /**
+   * \brief Add a batch of measurements to the estimator.
+   *
+   * The samples are folded into the estimate in order; the resulting state
+   * is the same as calling Measurement () once per sample.  The default
+   * implementation does exactly that, subclasses may override it to avoid
+   * the per-sample dispatch and logging cost.
+   *
+   * \param samples pointer to a contiguous array of RTT measures
+   * \param n number of samples in the array
+   */
+  virtual void MeasurementBatch (const Time *samples, std::size_t n);
+
   /**
    * \brief Copy object (including current internal state)
    * \returns a copy of itself
@@ -76,6 +94,17 @@ public:
    */
   virtual void Reset ();
 
+  /**
+   * \brief Start from a known estimate instead of the initial RTT.
+   *
+   * Only applies before the first sample, which still initialises the
+   * estimator as usual; meanwhile the seed is what the RTO is derived from.
+   *
+   * \param estimate the RTT estimate to start from
+   * \param variation the RTT variation to start from
+   */
+  void Seed (Time estimate, Time variation);
+
   /**
    * \brief gets the RTT estimate.
    * \return The RTT estimate.
@@ -98,8 +127,73 @@ public:
    */
   uint32_t GetNSamples (void) const;
 
+  /**
+   * \brief gets an estimate of a quantile of the RTT samples.
+   *
+   * Samples are only kept, in a sketch of bounded size, when the
+   * QuantileSketch attribute is set.
+   *
+   * \param q the quantile, 0 <= q <= 1 (e.g. 0.99 for the 99th percentile)
+   * \return The estimate, within QuantileAccuracy of the actual quantile,
+   * or zero if there is no sample or the sketch is disabled.
+   */
+  Time GetQuantile (double q) const;
+
+protected:
+  /**
+   * \brief Record a sample in the quantile sketch, if enabled.
+   *
+   * To be called by subclasses for every measurement.
+   *
+   * \param m the RTT sample
+   */
+  void RecordQuantileSample (Time m)
+  {
+    m_quantileSketch.Add (m);
+  }
+
 private:
+  /**
+   * \brief Enable or disable the quantile sketch
+   * \param enable true to keep a sketch of the samples
+   */
+  void SetQuantileSketch (bool enable);
+
+  /**
+   * \brief Whether the quantile sketch is enabled
+   * \return true if a sketch of the samples is kept
+   */
+  bool GetQuantileSketch (void) const;
+
+  /**
+   * \brief Set the relative accuracy of the quantile sketch
+   * \param alpha the accuracy, 0 < alpha < 1
+   */
+  void SetQuantileAccuracy (double alpha);
+
+  /**
+   * \brief Get the relative accuracy of the quantile sketch
+   * \return the accuracy
+   */
+  double GetQuantileAccuracy (void) const;
+
+  /**
+   * \brief Set the maximum number of buckets of the quantile sketch
+   * \param n the number of buckets
+   */
+  void SetQuantileMaxBuckets (uint32_t n);
+
+  /**
+   * \brief Get the maximum number of buckets of the quantile sketch
+   * \return the number of buckets
+   */
+  uint32_t GetQuantileMaxBuckets (void) const;
+
   Time m_initialEstimatedRtt; //!< Initial RTT estimation
+  bool              m_quantileEnabled {false};   //!< Keep a sketch of the samples
+  double            m_quantileAccuracy {0.01};   //!< Relative accuracy of the sketch
+  uint32_t          m_quantileMaxBuckets {1024}; //!< Memory bound of the sketch
+  RttQuantileSketch m_quantileSketch;            //!< Sketch of the samples
 
 protected:
   Time         m_estimatedRtt;            //!< Current estimate
@@ -120,6 +214,16 @@ protected:
  * The default values for the gain (alpha and beta) are set as documented
  * in RFC 6298.
  *
+ * With the modified RTT calculation the gains in use move away from the
+ * configured Alpha and Beta with the RTT rate of change.  The gains in
+ * use are kept within [MinAlpha, MaxAlpha] and [MinBeta, MaxBeta], then
+ * pulled back toward Alpha and Beta by a fraction GainDecay of the distance
+ * on every sample, and exported through the CurrentAlpha and CurrentBeta
+ * trace sources.  A gain of zero would stay at zero, as the rate of change
+ * only scales it: MinAlpha and MinBeta default to 1/64, and GainDecay to
+ * 1/32, so that a gain driven to its floor by a sudden change of the RTT
+ * returns to its configured value.
+ *
  */
 class RttMeanDeviation : public RttEstimator {
 public:
@@ -145,6 +249,13 @@ public:
    */
   void Measurement (Time measure);
 
+  /**
+   * \brief Add a batch of measurements to the estimator.
+   * \param samples pointer to a contiguous array of RTT measures
+   * \param n number of samples in the array
+   */
+  void MeasurementBatch (const Time *samples, std::size_t n);
+
   Ptr<RttEstimator> Copy () const;
 
   /**
@@ -152,7 +263,132 @@ public:
    */
   void Reset ();
 
+  /**
+   * \brief Set the gain used in estimating the RTT
+   *
+   * Whether the gain is a reciprocal power of two is worked out here,
+   * once, rather than on every measurement.  The gain in use is reset
+   * to this value.
+   *
+   * \param alpha the gain, 0 <= alpha <= 1
+   */
+  void SetAlpha (double alpha);
+
+  /**
+   * \brief Get the configured gain used in estimating the RTT
+   * \return the gain
+   */
+  double GetAlpha (void) const;
+
+  /**
+   * \brief Set the gain used in estimating the RTT variation
+   *
+   * Whether the gain is a reciprocal power of two is worked out here,
+   * once, rather than on every measurement.  The gain in use is reset
+   * to this value.
+   *
+   * \param beta the gain, 0 <= beta <= 1
+   */
+  void SetBeta (double beta);
+
+  /**
+   * \brief Get the configured gain used in estimating the RTT variation
+   * \return the gain
+   */
+  double GetBeta (void) const;
+
+  /**
+   * \brief Get the gain currently in use in estimating the RTT
+   *
+   * It differs from GetAlpha () only with the modified RTT calculation.
+   *
+   * \return the gain
+   */
+  double GetCurrentAlpha (void) const;
+
+  /**
+   * \brief Get the gain currently in use in estimating the RTT variation
+   *
+   * It differs from GetBeta () only with the modified RTT calculation.
+   *
+   * \return the gain
+   */
+  double GetCurrentBeta (void) const;
+
 private:
+  /**
+   * Set the gain in use for the RTT, along with its shift and
+   * fixed-point forms
+   * \param alpha the gain
+   */
+  void SetCurrentAlpha (double alpha);
+  /**
+   * Set the gain in use for the RTT variation, along with its shift and
+   * fixed-point forms
+   * \param beta the gain
+   */
+  void SetCurrentBeta (double beta);
+  /**
+   * Adapt the gains in use to the RTT rate of change, pull them back
+   * toward the configured gains and clamp them, in floating point.
+   * \param m time measurement
+   */
+  void AdaptGains (Time m);
+  /**
+   * Refresh the fixed-point copies of the gain bounds and decay.
+   */
+  void UpdateFixedPointLimits (void);
+  /**
+   * \param v the lower bound of the gain in use for the RTT
+   */
+  void SetMinAlpha (double v);
+  /**
+   * \return the lower bound of the gain in use for the RTT
+   */
+  double GetMinAlpha (void) const;
+  /**
+   * \param v the upper bound of the gain in use for the RTT
+   */
+  void SetMaxAlpha (double v);
+  /**
+   * \return the upper bound of the gain in use for the RTT
+   */
+  double GetMaxAlpha (void) const;
+  /**
+   * \param v the lower bound of the gain in use for the RTT variation
+   */
+  void SetMinBeta (double v);
+  /**
+   * \return the lower bound of the gain in use for the RTT variation
+   */
+  double GetMinBeta (void) const;
+  /**
+   * \param v the upper bound of the gain in use for the RTT variation
+   */
+  void SetMaxBeta (double v);
+  /**
+   * \return the upper bound of the gain in use for the RTT variation
+   */
+  double GetMaxBeta (void) const;
+  /**
+   * \param v the fraction of the distance to the configured gains
+   *          recovered on every sample
+   */
+  void SetGainDecay (double v);
+  /**
+   * \return the fraction of the distance to the configured gains
+   *          recovered on every sample
+   */
+  double GetGainDecay (void) const;
+
+  /**
+   * Fold a single measurement into the estimate.  Shared by the
+   * single-sample and batched entry points, so that both produce
+   * exactly the same state.
+   *
+   * \param m time measurement
+   */
+  void DoMeasurement (Time m);
   /** 
    * Utility function to check for possible conversion
    * of a double value (0 < value < 1) to a reciprocal power of two
@@ -163,7 +399,7 @@ private:
    * \param val value to check 
    * \return log base 2 (1/val) if reciprocal power of 2, or zero if not
    */
-  uint32_t CheckForReciprocalPowerOfTwo (double val) const;
+  static uint32_t CheckForReciprocalPowerOfTwo (double val);
   /**
    * Method to update the rtt and variation estimates using integer
    * arithmetic, used when the values of Alpha and Beta support the
@@ -182,11 +418,381 @@ private:
    * \param m time measurement
    */
   void FloatingPointUpdate (Time m);
-  double       m_alpha;       //!< Filter gain for average
-  double       m_beta;        //!< Filter gain for variation
+  /**
+   * Method to update the gains, the rtt and the variation estimates of
+   * the modified algorithm using fixed-point integer arithmetic.
+   *
+   * Gains are kept in Q.16 format (m_alphaQ, m_betaQ).  The RTT rate of
+   * change is truncated toward zero to Q.16, the adapted gains are
+   * rounded to the nearest Q.16 value (ties toward +infinity), the steps
+   * back toward the configured gains are rounded away from zero, and the
+   * result is clamped to the configured bounds.  The
+   * products of the error terms with the gains are rounded toward
+   * -infinity, so that with gains that are reciprocal powers of two the
+   * result is bit-identical to IntegerUpdate.  With other gains, the
+   * estimates stay within a few Time units per sample of those of the
+   * floating point version.
+   *
+   * If the previous measurement is zero the rate of change is undefined,
+   * and the gains are left untouched.
+   *
+   * \param m time measurement
+   */
+  void FixedPointModifiedUpdate (Time m);
+  double       m_alpha;       //!< Configured filter gain for average
+  double       m_beta;        //!< Configured filter gain for variation
+  TracedValue<double> m_currentAlpha; //!< Filter gain for average in use
+  TracedValue<double> m_currentBeta;  //!< Filter gain for variation in use
+  double       m_minAlpha;    //!< Lower bound of the gain for average in use
+  double       m_maxAlpha;    //!< Upper bound of the gain for average in use
+  double       m_minBeta;     //!< Lower bound of the gain for variation in use
+  double       m_maxBeta;     //!< Upper bound of the gain for variation in use
+  double       m_gainDecay;   //!< Fraction of the distance to the configured gains recovered per sample
+  uint32_t     m_rttShift {0};       //!< log base 2 (1/alpha in use), or zero if not a reciprocal power of two
+  uint32_t     m_variationShift {0}; //!< log base 2 (1/beta in use), or zero if not a reciprocal power of two
+  int64_t      m_alphaQ {0};        //!< Filter gain for average in use, Q.16 fixed point
+  int64_t      m_betaQ {0};         //!< Filter gain for variation in use, Q.16 fixed point
+  int64_t      m_baseAlphaQ {0};    //!< Configured filter gain for average, Q.16 fixed point
+  int64_t      m_baseBetaQ {0};     //!< Configured filter gain for variation, Q.16 fixed point
+  int64_t      m_minAlphaQ {0};     //!< m_minAlpha, Q.16 fixed point
+  int64_t      m_maxAlphaQ {0};     //!< m_maxAlpha, Q.16 fixed point
+  int64_t      m_minBetaQ {0};      //!< m_minBeta, Q.16 fixed point
+  int64_t      m_maxBetaQ {0};      //!< m_maxBeta, Q.16 fixed point
+  int64_t      m_gainDecayQ {0};    //!< m_gainDecay, Q.16 fixed point
   bool         modified_rtt_calc {false}; // if true, modified version of rtt calculation will be used
+  bool         m_fixedPoint {false};      //!< Run the modified calculation in fixed point
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief The RTT estimator of the Linux kernel (tcp_rtt_estimator)
+ *
+ * Same gains as RttMeanDeviation (1/8 and 1/4), run in the scaled
+ * integer arithmetic of the kernel: the smoothed RTT is kept times 8 and
+ * the mean deviation (mdev) times 4.  A sample below the estimate only
+ * moves mdev by 1/32 of the error, instead of 1/4.
+ *
+ * The variation used for the RTO (rttvar) follows the largest mdev seen
+ * in the current round (mdev_max), never below MinRttVar.  It grows as
+ * soon as mdev does, but only decays once per round, by a quarter of its
+ * distance to mdev_max.  A burst of stable samples therefore cannot
+ * collapse the RTO within a single window.
+ *
+ * The kernel ends a round when snd_una passes the snd_nxt recorded at its
+ * start.  The estimator does not see sequence numbers, so a round ends
+ * here with the first sample for a segment sent after the round started,
+ * that is sent at Now () minus the sample.
+ *
+ * GetVariation () returns rttvar / 4, so that SRTT + 4 * variation, as
+ * computed by RtoRfc6298, is the RTO of the kernel, SRTT + rttvar.
+ */
+class RttLinuxMeanDeviation : public RttEstimator {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RttLinuxMeanDeviation ();
+
+  /**
+   * \brief Copy constructor
+   * \param r the object to copy
+   */
+  RttLinuxMeanDeviation (const RttLinuxMeanDeviation& r);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  /**
+   * \brief Add a new measurement to the estimator.
+   * \param measure the new RTT measure.
+   */
+  void Measurement (Time measure);
+
+  Ptr<RttEstimator> Copy () const;
+
+  /**
+   * \brief Resets the estimator.
+   */
+  void Reset ();
+
+private:
+  Time    m_minRttVar;        //!< Floor of rttvar and reset value of mdev_max (tcp_rto_min)
+  int64_t m_srtt {0};         //!< Smoothed RTT, times 8, in Time integer units
+  int64_t m_mdev {0};         //!< Mean deviation, times 4, in Time integer units
+  int64_t m_mdevMax {0};      //!< Largest m_mdev of the current round
+  int64_t m_rttVar {0};       //!< Variation used for the RTO, times 4
+  Time    m_roundStart;       //!< Time at which the current round started
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief RTT estimator based on a scalar Kalman filter
+ *
+ * The RTT is modelled as a random walk observed through noisy samples:
+ * x(k) = x(k-1) + w and z(k) = x(k) + v, with w and v of variances Q
+ * (process noise) and R (measurement noise).  Each sample z moves the
+ * estimate x by K e, with e = z - x the innovation and K = P / (P + R)
+ * the Kalman gain, P being the variance of x predicted from the last
+ * sample.
+ *
+ * Neither noise is known beforehand; both are estimated from the
+ * innovations, smoothed with their own gain:
+ *  - the mean b of the innovations tells that x lags behind a change of
+ *    the path.  Q follows b^2, so that the filter speeds up after a
+ *    change and averages over many samples on a steady path;
+ *  - their spread about b, less the part due to P, gives R.
+ *
+ * An innovation beyond OutlierThreshold times its predicted standard
+ * deviation, sqrt (P + R), is clipped to it first, so that a lone spike
+ * (e.g. a retransmission on a wireless hop) neither drags x nor inflates
+ * R for the samples after it.
+ *
+ * GetEstimate () returns x.  GetVariation () returns the predicted
+ * standard deviation of the next sample, sqrt (P + Q + R), rather than the
+ * posterior deviation of x alone, sqrt (P), which shrinks to nothing on a
+ * steady path and would bring the RTO down to the SRTT.  The first sample
+ * z sets x = z and a variation of z / 2, as RFC 6298 does.
+ *
+ * Each sample costs a few floating point operations and one square root.
+ */
+class RttKalman : public RttEstimator {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RttKalman ();
+
+  /**
+   * \brief Copy constructor
+   * \param r the object to copy
+   */
+  RttKalman (const RttKalman& r);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  /**
+   * \brief Add a new measurement to the estimator.
+   * \param measure the new RTT measure.
+   */
+  void Measurement (Time measure);
+
+  Ptr<RttEstimator> Copy () const;
+
+  /**
+   * \brief Resets the estimator.
+   */
+  void Reset ();
+
+private:
+  double m_measurementNoiseGain; //!< Gain of the estimate of R
+  double m_processNoiseGain;     //!< Gain of the mean of the innovations
+  double m_outlierThreshold;     //!< Innovations are clipped to this many standard deviations
+  // State, in Time integer units (squared for the variances)
+  double m_x {0};                //!< Estimate of the RTT
+  double m_p {0};                //!< Variance of m_x
+  double m_q {0};                //!< Process noise variance
+  double m_r {0};                //!< Measurement noise variance
+  double m_bias {0};             //!< Mean of the innovations
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Trend-aware RTT estimator (Holt's linear exponential smoothing)
+ *
+ * Where the modified RTT calculation of RttMeanDeviation reacts to a
+ * changing RTT by rescaling its gains, this estimator tracks the level L
+ * of the RTT and its trend T, the change of the RTT per unit of time,
+ * explicitly.  A sample z taken dt after the previous one is compared to
+ * the forecast F = L + T dt, and with the error e = z - F:
+ *
+ *   L = F + LevelGain e
+ *   V = V + VariationGain (|e| - V)
+ *
+ * The slope between two samples a few microseconds apart is mostly
+ * noise, so the trend is measured over rounds of one RTT instead: when a
+ * round of length D ends, over which the level went from L0 to L,
+ *
+ *   T = T + TrendGain ((L - L0) / D - T)
+ *
+ * While the RTT grows, as a queue builds up, the segments sent now will
+ * see a larger RTT than the last sample: GetEstimate () projects L one
+ * RTT ahead, to L + T L.  A falling trend is not projected, so that the
+ * RTO never drops below the level on a queue that drains.  GetVariation ()
+ * returns V, the mean deviation of the forecast errors.
+ *
+ * The first sample z sets L = z, T = 0 and V = z / 2, as RFC 6298 does.
+ */
+class RttHolt : public RttEstimator {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RttHolt ();
+
+  /**
+   * \brief Copy constructor
+   * \param r the object to copy
+   */
+  RttHolt (const RttHolt& r);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  /**
+   * \brief Add a new measurement to the estimator.
+   * \param measure the new RTT measure.
+   */
+  void Measurement (Time measure);
+
+  Ptr<RttEstimator> Copy () const;
+
+  /**
+   * \brief Resets the estimator.
+   */
+  void Reset ();
+
+  /**
+   * \brief Get the trend of the RTT
+   * \return the change of the RTT per unit of time
+   */
+  double GetTrend (void) const;
+
+private:
+  double m_levelGain;      //!< Gain used in estimating the level
+  double m_trendGain;      //!< Gain used in estimating the trend
+  double m_variationGain;  //!< Gain used in estimating the variation
+  // State, in Time integer units
+  double m_level {0};      //!< Level of the RTT
+  double m_trend {0};      //!< Change of the RTT per unit of time
+  double m_variation {0};  //!< Mean deviation of the forecast errors
+  Time   m_lastSample;     //!< Time of the previous sample
+  double m_roundLevel {0}; //!< Level at the start of the current round
+  Time   m_roundStart;     //!< Start of the current round, over which the trend is measured
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief The "Mean--Deviation" RTT estimator with compile-time gains
+ *
+ * Same estimator as RttMeanDeviation, with alpha = 1 / 2^RttShift and
+ * beta = 1 / 2^VariationShift fixed at compile time.  The gains are not
+ * attributes and are not checked on each sample: every measurement goes
+ * straight to the integer update of Jacobson/Karels paper appendix A.2.
+ * The modified RTT calculation, which adapts the gains per sample, is
+ * not available in this variant.
+ *
+ * RttMeanDeviationRfc6298 is the instance with the gains of RFC 6298.
+ */
+template <uint32_t RttShift, uint32_t VariationShift>
+class RttMeanDeviationT : public RttEstimator {
+public:
+  static_assert (RttShift > 0 && RttShift < 32, "RttShift must be in [1, 31]");
+  static_assert (VariationShift > 0 && VariationShift < 32, "VariationShift must be in [1, 31]");
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId (("ns3::RttMeanDeviationT<" + std::to_string (RttShift) +
+                                 "," + std::to_string (VariationShift) + ">").c_str ())
+      .SetParent<RttEstimator> ()
+      .SetGroupName ("Internet")
+      .AddConstructor<RttMeanDeviationT<RttShift, VariationShift> > ()
+    ;
+    return tid;
+  }
+
+  RttMeanDeviationT () {}
+
+  /**
+   * \brief Copy constructor
+   * \param r the object to copy
+   */
+  RttMeanDeviationT (const RttMeanDeviationT& r) : RttEstimator (r) {}
+
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+
+  /**
+   * \brief Add a new measurement to the estimator.
+   * \param measure the new RTT measure.
+   */
+  void Measurement (Time measure)
+  {
+    DoMeasurement (measure.GetInteger ());
+  }
+
+  /**
+   * \brief Add a batch of measurements to the estimator.
+   * \param samples pointer to a contiguous array of RTT measures
+   * \param n number of samples in the array
+   */
+  void MeasurementBatch (const Time *samples, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i)
+      {
+        DoMeasurement (samples[i].GetInteger ());
+      }
+  }
+
+  Ptr<RttEstimator> Copy () const
+  {
+    return CopyObject<RttMeanDeviationT<RttShift, VariationShift> > (this);
+  }
+
+private:
+  /**
+   * Integer update of the estimate, see RttMeanDeviation::IntegerUpdate
+   *
+   * \param meas time measurement, in Time integer units
+   */
+  void DoMeasurement (int64_t meas)
+  {
+    RecordQuantileSample (Time::From (meas));
+    if (m_nSamples)
+      {
+        int64_t delta = meas - m_estimatedRtt.GetInteger ();
+        int64_t srtt = (m_estimatedRtt.GetInteger () << RttShift) + delta;
+        m_estimatedRtt = Time::From (srtt >> RttShift);
+        if (delta < 0)
+          {
+            delta = -delta;
+          }
+        delta -= m_estimatedVariation.GetInteger ();
+        int64_t rttvar = m_estimatedVariation.GetInteger () << VariationShift;
+        rttvar += delta;
+        m_estimatedVariation = Time::From (rttvar >> VariationShift);
+      }
+    else
+      { // First sample
+        m_estimatedRtt = Time::From (meas);
+        m_estimatedVariation = Time::From (meas) / 2;
+      }
+    m_nSamples++;
+  }
 };
 
+/**
+ * \ingroup tcp
+ * RttMeanDeviationT with the RFC 6298 gains (alpha = 1/8, beta = 1/4)
+ */
+typedef RttMeanDeviationT<3, 2> RttMeanDeviationRfc6298;
+
 } // namespace ns3
 
 #endif /* RTT_ESTIMATOR_H */
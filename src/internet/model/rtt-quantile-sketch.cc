@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <cmath>
+#include <algorithm>
+
+#include "rtt-quantile-sketch.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+RttQuantileSketch::RttQuantileSketch ()
+  : m_gamma (1),
+    m_invLog2Gamma (0),
+    m_offset (0),
+    m_anchored (false),
+    m_zeroCount (0),
+    m_count (0)
+{
+}
+
+void
+RttQuantileSketch::Configure (double alpha, uint32_t maxBuckets)
+{
+  NS_ASSERT_MSG (alpha > 0 && alpha < 1, "Accuracy must be in (0, 1)");
+  NS_ASSERT_MSG (maxBuckets > 0, "At least one bucket is needed");
+  m_gamma = (1 + alpha) / (1 - alpha);
+  m_invLog2Gamma = 1 / std::log2 (m_gamma);
+  m_buckets.assign (maxBuckets, 0);
+  Clear ();
+}
+
+void
+RttQuantileSketch::Disable (void)
+{
+  std::vector<uint64_t> ().swap (m_buckets);
+  Clear ();
+}
+
+void
+RttQuantileSketch::Clear (void)
+{
+  std::fill (m_buckets.begin (), m_buckets.end (), 0);
+  m_offset = 0;
+  m_anchored = false;
+  m_zeroCount = 0;
+  m_count = 0;
+}
+
+void
+RttQuantileSketch::Add (Time sample)
+{
+  if (m_buckets.empty ())
+    {
+      return;
+    }
+  m_count++;
+  int64_t x = sample.GetInteger ();
+  if (x <= 0)
+    {
+      m_zeroCount++;
+      return;
+    }
+
+  int32_t index = static_cast<int32_t> (std::ceil (std::log2 (static_cast<double> (x)) * m_invLog2Gamma));
+  int32_t size = static_cast<int32_t> (m_buckets.size ());
+  if (!m_anchored)
+    {
+      // Center the range on the first sample
+      m_offset = index - size / 2;
+      m_anchored = true;
+    }
+  if (index >= m_offset + size)
+    {
+      ShiftUp (index);
+    }
+  m_buckets[std::max (index - m_offset, 0)]++;
+}
+
+void
+RttQuantileSketch::ShiftUp (int32_t index)
+{
+  int32_t size = static_cast<int32_t> (m_buckets.size ());
+  int32_t shift = index - (m_offset + size - 1);
+  if (shift >= size)
+    {
+      uint64_t total = 0;
+      for (uint64_t c : m_buckets)
+        {
+          total += c;
+        }
+      std::fill (m_buckets.begin (), m_buckets.end (), 0);
+      m_buckets[0] = total;
+    }
+  else
+    {
+      uint64_t merged = 0;
+      for (int32_t i = 0; i <= shift; ++i)
+        {
+          merged += m_buckets[i];
+        }
+      std::move (m_buckets.begin () + shift + 1, m_buckets.end (), m_buckets.begin () + 1);
+      std::fill (m_buckets.end () - shift, m_buckets.end (), 0);
+      m_buckets[0] = merged;
+    }
+  m_offset += shift;
+}
+
+Time
+RttQuantileSketch::GetQuantile (double q) const
+{
+  if (m_count == 0)
+    {
+      return Time (0);
+    }
+  q = std::min (std::max (q, 0.0), 1.0);
+  uint64_t rank = static_cast<uint64_t> (q * (m_count - 1));
+  if (rank < m_zeroCount)
+    {
+      return Time (0);
+    }
+  uint64_t seen = m_zeroCount;
+  for (std::size_t i = 0; i < m_buckets.size (); ++i)
+    {
+      seen += m_buckets[i];
+      if (seen > rank)
+        {
+          // Midpoint of the bucket (gamma^(k-1), gamma^k], in relative terms
+          double k = static_cast<double> (m_offset + static_cast<int32_t> (i));
+          double value = 2 * std::exp2 (k / m_invLog2Gamma) / (m_gamma + 1);
+          return Time::From (static_cast<int64_t> (std::llround (value)));
+        }
+    }
+  return Time (0);
+}
+
+uint64_t
+RttQuantileSketch::GetCount (void) const
+{
+  return m_count;
+}
+
+} // namespace ns3
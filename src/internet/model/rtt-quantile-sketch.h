@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef RTT_QUANTILE_SKETCH_H
+#define RTT_QUANTILE_SKETCH_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Streaming quantile sketch of RTT samples (DDSketch)
+ *
+ * A sample x > 0, in Time integer units, is counted in the bucket of
+ * index ceil (log_gamma (x)), with gamma = (1 + alpha) / (1 - alpha).  Any
+ * quantile is then returned with a relative error of at most alpha, as
+ * long as it falls within the buckets kept.
+ *
+ * Memory is bounded: at most maxBuckets consecutive buckets are kept.
+ * When a sample falls above them, the range slides up and the buckets
+ * left behind are merged into the lowest kept one; samples below the
+ * range are counted in the lowest bucket as well.  Only low quantiles
+ * lose accuracy this way.  With alpha = 1 % and 1024 buckets, the range
+ * spans about nine decades, which covers any RTT in practice.
+ *
+ * Adding a sample costs one logarithm and one increment.
+ */
+class RttQuantileSketch
+{
+public:
+  /**
+   * \brief Constructor of a disabled sketch, see Configure ()
+   */
+  RttQuantileSketch ();
+
+  /**
+   * \brief Set the accuracy and the size of the sketch, and clear it
+   *
+   * \param alpha relative accuracy, 0 < alpha < 1
+   * \param maxBuckets maximum number of buckets, at least 1
+   */
+  void Configure (double alpha, uint32_t maxBuckets);
+
+  /**
+   * \brief Release the memory of the sketch; Add () is then ignored
+   */
+  void Disable (void);
+
+  /**
+   * \brief Whether the sketch is configured
+   * \return true if Add () records samples
+   */
+  bool IsEnabled (void) const
+  {
+    return !m_buckets.empty ();
+  }
+
+  /**
+   * \brief Record a sample
+   * \param sample the RTT sample
+   */
+  void Add (Time sample);
+
+  /**
+   * \brief Get an estimate of a quantile of the samples recorded
+   * \param q the quantile, 0 <= q <= 1
+   * \return the estimate, or zero if no sample was recorded
+   */
+  Time GetQuantile (double q) const;
+
+  /**
+   * \brief Get the number of samples recorded
+   * \return the number of samples
+   */
+  uint64_t GetCount (void) const;
+
+  /**
+   * \brief Forget the samples, keeping the configuration
+   */
+  void Clear (void);
+
+private:
+  /**
+   * \brief Slide the range of buckets up so that it ends at the given
+   * bucket index, merging the buckets left behind into the lowest one
+   * \param index the new highest bucket index
+   */
+  void ShiftUp (int32_t index);
+
+  double                m_gamma;        //!< Ratio between consecutive bucket bounds
+  double                m_invLog2Gamma; //!< 1 / log2 (gamma)
+  std::vector<uint64_t> m_buckets;      //!< Counts, m_buckets[i] is bucket m_offset + i
+  int32_t               m_offset;       //!< Index of the lowest bucket kept
+  bool                  m_anchored;     //!< The range was placed around a first sample
+  uint64_t              m_zeroCount;    //!< Samples lower than or equal to zero
+  uint64_t              m_count;        //!< Samples recorded
+};
+
+} // namespace ns3
+
+#endif /* RTT_QUANTILE_SKETCH_H */
@@ -0,0 +1,483 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+#include "rtt-sample-filter.h"
+#include "ns3/object-factory.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RttSampleFilter");
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Base class of the stages
+
+NS_OBJECT_ENSURE_REGISTERED (RttSampleFilter);
+
+TypeId
+RttSampleFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RttSampleFilter")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+  ;
+  return tid;
+}
+
+RttSampleFilter::RttSampleFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RttSampleFilter::RttSampleFilter (const RttSampleFilter &f)
+  : Object (f)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RttSampleFilter::~RttSampleFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Hampel filter
+
+NS_OBJECT_ENSURE_REGISTERED (RttHampelFilter);
+
+TypeId
+RttHampelFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RttHampelFilter")
+    .SetParent<RttSampleFilter> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RttHampelFilter> ()
+    .AddAttribute ("WindowSize",
+                   "Number of samples the median is taken over",
+                   UintegerValue (7),
+                   MakeUintegerAccessor (&RttHampelFilter::SetWindowSize,
+                                         &RttHampelFilter::GetWindowSize),
+                   MakeUintegerChecker<uint32_t> (3, MAX_WINDOW))
+    .AddAttribute ("Threshold",
+                   "Distance to the median, in standard deviations, beyond which "
+                   "a sample is an outlier",
+                   DoubleValue (5.0),
+                   MakeDoubleAccessor (&RttHampelFilter::m_threshold),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MinDeviation",
+                   "Lower bound of the standard deviation of the samples",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&RttHampelFilter::m_minDeviation),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+RttHampelFilter::RttHampelFilter ()
+  : m_windowSize (7)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RttHampelFilter::RttHampelFilter (const RttHampelFilter &f)
+  : RttSampleFilter (f),
+    m_window (f.m_window),
+    m_sorted (f.m_sorted),
+    m_windowSize (f.m_windowSize),
+    m_head (f.m_head),
+    m_count (f.m_count),
+    m_threshold (f.m_threshold),
+    m_minDeviation (f.m_minDeviation),
+    m_outliers (f.m_outliers)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+RttHampelFilter::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+bool
+RttHampelFilter::Filter (Time &sample)
+{
+  int64_t x = sample.GetInteger ();
+
+  // Keep the window sorted as well: drop the oldest sample, if the
+  // window is full, and insert the new one in place.  The positions are
+  // counted rather than searched: no branch depends on the samples
+  int64_t *begin = m_sorted.data ();
+  if (m_count == m_windowSize)
+    {
+      int64_t old = m_window[m_head];
+      uint32_t at = 0;
+      for (uint32_t i = 0; i < m_count; ++i)
+        {
+          at += m_sorted[i] < old;
+        }
+      std::copy (begin + at + 1, begin + m_count, begin + at);
+      m_count--;
+    }
+  uint32_t at = 0;
+  for (uint32_t i = 0; i < m_count; ++i)
+    {
+      at += m_sorted[i] <= x;
+    }
+  std::copy_backward (begin + at, begin + m_count, begin + m_count + 1);
+  m_sorted[at] = x;
+  m_count++;
+  m_window[m_head] = x;
+  m_head = (m_head + 1) % m_windowSize;
+  if (m_count < 3)
+    {
+      return true;
+    }
+
+  // Median, then median absolute deviation: the deviations grow from
+  // the median outward on both sides, merge them up to the middle one
+  uint32_t mid = m_count / 2;
+  int64_t median = m_sorted[mid];
+  uint32_t lo = mid;
+  uint32_t hi = mid;
+  int64_t mad = 0;
+  for (uint32_t n = 0; n < mid; ++n)
+    {
+      int64_t down = lo > 0 ? median - m_sorted[lo - 1] : INT64_MAX;
+      int64_t up = hi + 1 < m_count ? m_sorted[hi + 1] - median : INT64_MAX;
+      if (down <= up)
+        {
+          mad = down;
+          lo--;
+        }
+      else
+        {
+          mad = up;
+          hi++;
+        }
+    }
+  double sigma = std::max (1.4826 * static_cast<double> (mad),
+                           static_cast<double> (m_minDeviation.GetInteger ()));
+
+  if (static_cast<double> (std::llabs (x - median)) > m_threshold * sigma)
+    {
+      NS_LOG_LOGIC ("Outlier " << sample << " replaced by " << Time::From (median));
+      sample = Time::From (median);
+      m_outliers++;
+    }
+  return true;
+}
+
+void
+RttHampelFilter::Reset (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_head = 0;
+  m_count = 0;
+}
+
+Ptr<RttSampleFilter>
+RttHampelFilter::Copy (void) const
+{
+  return CopyObject<RttHampelFilter> (this);
+}
+
+uint32_t
+RttHampelFilter::GetOutlierCount (void) const
+{
+  return m_outliers;
+}
+
+void
+RttHampelFilter::SetWindowSize (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  m_windowSize = std::min (std::max (n, 3u), MAX_WINDOW);
+  Reset ();
+}
+
+uint32_t
+RttHampelFilter::GetWindowSize (void) const
+{
+  return m_windowSize;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Delayed ACK compensation
+
+NS_OBJECT_ENSURE_REGISTERED (RttAckDelayFilter);
+
+TypeId
+RttAckDelayFilter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RttAckDelayFilter")
+    .SetParent<RttSampleFilter> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RttAckDelayFilter> ()
+    .AddAttribute ("AckDelay",
+                   "Delay removed from the samples at least this much above the "
+                   "minimum RTT, the delayed ACK timeout of the receiver",
+                   TimeValue (MilliSeconds (200)),
+                   MakeTimeAccessor (&RttAckDelayFilter::m_ackDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("MinRttWindow",
+                   "Window of the minimum RTT, zero to keep the minimum of all samples",
+                   TimeValue (Seconds (10.0)),
+                   MakeTimeAccessor (&RttAckDelayFilter::SetMinRttWindow,
+                                     &RttAckDelayFilter::GetMinRttWindow),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+RttAckDelayFilter::RttAckDelayFilter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RttAckDelayFilter::RttAckDelayFilter (const RttAckDelayFilter &f)
+  : RttSampleFilter (f),
+    m_ackDelay (f.m_ackDelay),
+    m_minRtt (f.m_minRtt)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+RttAckDelayFilter::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+bool
+RttAckDelayFilter::Filter (Time &sample)
+{
+  Time minRtt = m_minRtt.Update (Simulator::Now (), sample);
+  if (sample >= minRtt + m_ackDelay)
+    {
+      sample -= m_ackDelay;
+    }
+  return true;
+}
+
+void
+RttAckDelayFilter::Reset (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_minRtt.Reset ();
+}
+
+Ptr<RttSampleFilter>
+RttAckDelayFilter::Copy (void) const
+{
+  return CopyObject<RttAckDelayFilter> (this);
+}
+
+void
+RttAckDelayFilter::SetMinRttWindow (Time window)
+{
+  NS_LOG_FUNCTION (this << window);
+  m_minRtt.SetWindow (window);
+}
+
+Time
+RttAckDelayFilter::GetMinRttWindow (void) const
+{
+  return m_minRtt.GetWindow ();
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Estimator behind a pipeline of stages
+
+NS_OBJECT_ENSURE_REGISTERED (RttFilteredEstimator);
+
+TypeId
+RttFilteredEstimator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RttFilteredEstimator")
+    .SetParent<RttEstimator> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RttFilteredEstimator> ()
+    .AddAttribute ("EstimatorType",
+                   "Type of the estimator fed with the filtered samples",
+                   TypeIdValue (RttMeanDeviation::GetTypeId ()),
+                   MakeTypeIdAccessor (&RttFilteredEstimator::SetEstimatorType,
+                                       &RttFilteredEstimator::GetEstimatorType),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("Filters",
+                   "Comma-separated types of the stages the samples go through, in order",
+                   StringValue ("ns3::RttHampelFilter"),
+                   MakeStringAccessor (&RttFilteredEstimator::SetFilters,
+                                       &RttFilteredEstimator::GetFilters),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+RttFilteredEstimator::RttFilteredEstimator ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RttFilteredEstimator::RttFilteredEstimator (const RttFilteredEstimator &c)
+  : RttEstimator (c)
+{
+  NS_LOG_FUNCTION (this);
+  if (c.m_estimator)
+    {
+      m_estimator = c.m_estimator->Copy ();
+    }
+  for (const Ptr<RttSampleFilter> &f : c.m_filters)
+    {
+      m_filters.push_back (f->Copy ());
+    }
+}
+
+TypeId
+RttFilteredEstimator::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+RttFilteredEstimator::Measurement (Time measure)
+{
+  NS_LOG_FUNCTION (this << measure);
+  for (const Ptr<RttSampleFilter> &f : m_filters)
+    {
+      if (!f->Filter (measure))
+        {
+          NS_LOG_LOGIC ("Sample discarded by " << f->GetInstanceTypeId ().GetName ());
+          return;
+        }
+    }
+  RecordQuantileSample (measure);
+  m_estimator->Measurement (measure);
+  Sync ();
+  prev_rtt = measure;
+}
+
+Ptr<RttEstimator>
+RttFilteredEstimator::Copy () const
+{
+  NS_LOG_FUNCTION (this);
+  return CopyObject<RttFilteredEstimator> (this);
+}
+
+void
+RttFilteredEstimator::Reset ()
+{
+  NS_LOG_FUNCTION (this);
+  RttEstimator::Reset ();
+  for (const Ptr<RttSampleFilter> &f : m_filters)
+    {
+      f->Reset ();
+    }
+  if (m_estimator)
+    {
+      m_estimator->Reset ();
+      Sync ();
+    }
+}
+
+void
+RttFilteredEstimator::AddFilter (Ptr<RttSampleFilter> filter)
+{
+  NS_LOG_FUNCTION (this << filter);
+  m_filters.push_back (filter);
+}
+
+Ptr<RttEstimator>
+RttFilteredEstimator::GetEstimator (void) const
+{
+  return m_estimator;
+}
+
+void
+RttFilteredEstimator::SetEstimatorType (TypeId tid)
+{
+  NS_LOG_FUNCTION (this << tid);
+  // A filtered estimator would wrap another one, without end
+  NS_ABORT_MSG_IF (tid == GetTypeId () || tid.IsChildOf (GetTypeId ()),
+                   "RttFilteredEstimator cannot wrap " << tid.GetName ());
+  ObjectFactory factory;
+  factory.SetTypeId (tid);
+  m_estimator = factory.Create<RttEstimator> ();
+  Sync ();
+}
+
+TypeId
+RttFilteredEstimator::GetEstimatorType (void) const
+{
+  return m_estimator ? m_estimator->GetInstanceTypeId () : RttMeanDeviation::GetTypeId ();
+}
+
+void
+RttFilteredEstimator::SetFilters (std::string filters)
+{
+  NS_LOG_FUNCTION (this << filters);
+  m_filters.clear ();
+  std::istringstream iss (filters);
+  std::string name;
+  while (std::getline (iss, name, ','))
+    {
+      if (name.empty ())
+        {
+          continue;
+        }
+      ObjectFactory factory;
+      factory.SetTypeId (name);
+      m_filters.push_back (factory.Create<RttSampleFilter> ());
+    }
+}
+
+std::string
+RttFilteredEstimator::GetFilters (void) const
+{
+  std::string filters;
+  for (const Ptr<RttSampleFilter> &f : m_filters)
+    {
+      if (!filters.empty ())
+        {
+          filters += ",";
+        }
+      filters += f->GetInstanceTypeId ().GetName ();
+    }
+  return filters;
+}
+
+void
+RttFilteredEstimator::Sync (void)
+{
+  m_estimatedRtt = m_estimator->GetEstimate ();
+  m_estimatedVariation = m_estimator->GetVariation ();
+  m_nSamples = m_estimator->GetNSamples ();
+}
+
+} // namespace ns3
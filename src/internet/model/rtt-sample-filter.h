@@ -0,0 +1,298 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef RTT_SAMPLE_FILTER_H
+#define RTT_SAMPLE_FILTER_H
+
+#include <stdint.h>
+#include <array>
+#include <string>
+#include <vector>
+
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "rtt-estimator.h"
+#include "min-rtt-filter.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief A stage of the pipeline of RTT samples of RttFilteredEstimator
+ *
+ * A stage sees every sample before the estimator does, and may change it
+ * or discard it.  Stages keep a fixed amount of state and must not
+ * allocate memory per sample.
+ */
+class RttSampleFilter : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RttSampleFilter ();
+
+  /**
+   * \brief Copy constructor
+   * \param f the object to copy
+   */
+  RttSampleFilter (const RttSampleFilter &f);
+
+  virtual ~RttSampleFilter ();
+
+  /**
+   * \brief Process a sample
+   * \param sample the RTT sample, which the stage may change
+   * \return false to discard the sample
+   */
+  virtual bool Filter (Time &sample) = 0;
+
+  /**
+   * \brief Forget the samples seen
+   */
+  virtual void Reset (void) = 0;
+
+  /**
+   * \brief Copy the stage, including its state
+   * \return a copy of the stage
+   */
+  virtual Ptr<RttSampleFilter> Copy (void) const = 0;
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Hampel filter: replace the outliers by the median of the window
+ *
+ * The last WindowSize samples are kept.  A sample farther from their
+ * median than Threshold times their standard deviation, estimated as
+ * 1.4826 times their median absolute deviation (MAD), is replaced by the
+ * median.  The deviation is never taken below MinDeviation, so that a
+ * steady path, whose MAD is zero, does not turn every jitter into an
+ * outlier.
+ *
+ * The raw sample enters the window either way: a lone spike is removed,
+ * while a change of the path is let through once it makes up half the
+ * window.  The window is also kept sorted, so that the median is read
+ * directly, and the MAD found by walking out of the median on both
+ * sides: a sample costs O(WindowSize) moves, with no allocation.
+ */
+class RttHampelFilter : public RttSampleFilter
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  static const uint32_t MAX_WINDOW = 31; //!< Largest window
+
+  RttHampelFilter ();
+
+  /**
+   * \brief Copy constructor
+   * \param f the object to copy
+   */
+  RttHampelFilter (const RttHampelFilter &f);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual bool Filter (Time &sample);
+  virtual void Reset (void);
+  virtual Ptr<RttSampleFilter> Copy (void) const;
+
+  /**
+   * \brief Get the number of samples replaced so far
+   * \return the number of outliers
+   */
+  uint32_t GetOutlierCount (void) const;
+
+private:
+  /**
+   * \brief Set the number of samples kept, and forget them
+   * \param n the number of samples, 3 <= n <= MAX_WINDOW
+   */
+  void SetWindowSize (uint32_t n);
+
+  /**
+   * \brief Get the number of samples kept
+   * \return the number of samples
+   */
+  uint32_t GetWindowSize (void) const;
+
+  std::array<int64_t, MAX_WINDOW> m_window; //!< Last samples, in Time integer units, in arrival order
+  std::array<int64_t, MAX_WINDOW> m_sorted; //!< Same samples, sorted
+  uint32_t m_windowSize;   //!< Number of samples kept
+  uint32_t m_head {0};     //!< Slot of the next sample
+  uint32_t m_count {0};    //!< Samples in the window
+  double   m_threshold;    //!< Outlier threshold, in standard deviations
+  Time     m_minDeviation; //!< Lower bound of the standard deviation
+  uint32_t m_outliers {0}; //!< Samples replaced so far
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Remove the delay of delayed ACKs from the RTT samples
+ *
+ * A receiver delaying its ACKs inflates the sample by up to its delayed
+ * ACK timeout.  As QUIC does (RFC 9002, Section 5.3), a sample at least
+ * AckDelay above the minimum RTT has AckDelay subtracted; samples closer
+ * to the minimum are left alone, so that no sample is brought below it.
+ * The minimum is taken over a window of MinRttWindow.
+ *
+ * TCP does not tell the actual delay of each ACK, so AckDelay is the
+ * largest one, the delayed ACK timeout of the receiver (DelAckTimeout,
+ * 200 ms in ns-3).  A queue of more than AckDelay gets underestimated by
+ * the same amount: use this stage where the ACK delay dominates.
+ */
+class RttAckDelayFilter : public RttSampleFilter
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RttAckDelayFilter ();
+
+  /**
+   * \brief Copy constructor
+   * \param f the object to copy
+   */
+  RttAckDelayFilter (const RttAckDelayFilter &f);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual bool Filter (Time &sample);
+  virtual void Reset (void);
+  virtual Ptr<RttSampleFilter> Copy (void) const;
+
+private:
+  /**
+   * \brief Set the window of the minimum RTT
+   * \param window the window, zero to keep the minimum of all samples
+   */
+  void SetMinRttWindow (Time window);
+
+  /**
+   * \brief Get the window of the minimum RTT
+   * \return the window
+   */
+  Time GetMinRttWindow (void) const;
+
+  Time         m_ackDelay; //!< Delay removed from the delayed samples
+  MinRttFilter m_minRtt;   //!< Windowed minimum of the raw samples
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief RTT estimator fed through a pipeline of sample filters
+ *
+ * Wraps an estimator of type EstimatorType and passes every sample
+ * through the stages listed in Filters, in order, before it.  A stage may
+ * change a sample, e.g. RttHampelFilter replaces outliers, or discard
+ * it.  Estimate and variation are those of the wrapped estimator.  The
+ * stages are made once, when the attribute is set: the pipeline costs
+ * no allocation per sample.
+ */
+class RttFilteredEstimator : public RttEstimator
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RttFilteredEstimator ();
+
+  /**
+   * \brief Copy constructor
+   * \param r the object to copy
+   */
+  RttFilteredEstimator (const RttFilteredEstimator &r);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  /**
+   * \brief Filter a new measurement and add it to the wrapped estimator.
+   * \param measure the new RTT measure.
+   */
+  void Measurement (Time measure);
+
+  Ptr<RttEstimator> Copy () const;
+
+  /**
+   * \brief Resets the estimator and the stages.
+   */
+  void Reset ();
+
+  /**
+   * \brief Append a stage to the pipeline
+   * \param filter the stage
+   */
+  void AddFilter (Ptr<RttSampleFilter> filter);
+
+  /**
+   * \brief Get the wrapped estimator
+   * \return the estimator
+   */
+  Ptr<RttEstimator> GetEstimator (void) const;
+
+private:
+  /**
+   * \brief Create the wrapped estimator
+   * \param tid the type of the estimator, which must not be an
+   * RttFilteredEstimator
+   */
+  void SetEstimatorType (TypeId tid);
+
+  /**
+   * \brief Get the type of the wrapped estimator
+   * \return the type of the estimator
+   */
+  TypeId GetEstimatorType (void) const;
+
+  /**
+   * \brief Create the stages of the pipeline
+   * \param filters comma-separated types of the stages, in order
+   */
+  void SetFilters (std::string filters);
+
+  /**
+   * \brief Get the stages of the pipeline
+   * \return comma-separated types of the stages, in order
+   */
+  std::string GetFilters (void) const;
+
+  /**
+   * \brief Copy the estimate of the wrapped estimator
+   */
+  void Sync (void);
+
+  Ptr<RttEstimator>                 m_estimator; //!< Wrapped estimator
+  std::vector<Ptr<RttSampleFilter> > m_filters;  //!< Stages, in order
+};
+
+} // namespace ns3
+
+#endif /* RTT_SAMPLE_FILTER_H */
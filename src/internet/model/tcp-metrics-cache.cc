@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "tcp-metrics-cache.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpMetricsCache");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpMetricsCache);
+
+TypeId
+TcpMetricsCache::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpMetricsCache")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpMetricsCache> ()
+    .AddAttribute ("MaxEntries",
+                   "Maximum number of destinations in the cache",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&TcpMetricsCache::SetMaxEntries,
+                                         &TcpMetricsCache::GetMaxEntries),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Timeout",
+                   "Age after which the metrics of a destination are dropped",
+                   TimeValue (Seconds (3600.0)), // TCP_METRICS_TIMEOUT in Linux
+                   MakeTimeAccessor (&TcpMetricsCache::m_timeout),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+TcpMetricsCache::TcpMetricsCache ()
+  : m_maxEntries (1024)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpMetricsCache::~TcpMetricsCache ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ptr<TcpMetricsCache>
+TcpMetricsCache::GetOrCreate (Ptr<Node> node)
+{
+  Ptr<TcpMetricsCache> cache = node->GetObject<TcpMetricsCache> ();
+  if (!cache)
+    {
+      cache = CreateObject<TcpMetricsCache> ();
+      node->AggregateObject (cache);
+    }
+  return cache;
+}
+
+bool
+TcpMetricsCache::Lookup (const Address &peer, Metrics *metrics)
+{
+  NS_LOG_FUNCTION (this << peer);
+  auto it = m_index.find (peer);
+  if (it == m_index.end ())
+    {
+      return false;
+    }
+  if (Simulator::Now () - it->second->second.updated > m_timeout)
+    {
+      NS_LOG_LOGIC ("Metrics of " << peer << " expired");
+      m_lru.erase (it->second);
+      m_index.erase (it);
+      return false;
+    }
+  m_lru.splice (m_lru.begin (), m_lru, it->second);
+  *metrics = it->second->second;
+  return true;
+}
+
+void
+TcpMetricsCache::Update (const Address &peer, Time srtt, Time rttVar, Time minRtt)
+{
+  NS_LOG_FUNCTION (this << peer << srtt << rttVar << minRtt);
+  auto it = m_index.find (peer);
+  if (it == m_index.end ()
+      || Simulator::Now () - it->second->second.updated > m_timeout)
+    {
+      if (it != m_index.end ())
+        {
+          m_lru.erase (it->second);
+          m_index.erase (it);
+        }
+      Metrics m = {srtt, rttVar, minRtt, Simulator::Now ()};
+      m_lru.emplace_front (peer, m);
+      m_index[peer] = m_lru.begin ();
+      Trim ();
+      return;
+    }
+
+  m_lru.splice (m_lru.begin (), m_lru, it->second);
+  Metrics &m = it->second->second;
+
+  // tcp_update_metrics (): follow an increase at once, a decrease slowly
+  if (srtt >= m.srtt)
+    {
+      m.srtt = srtt;
+    }
+  else
+    {
+      m.srtt = m.srtt - (m.srtt - srtt) / 8;
+    }
+  if (rttVar >= m.rttVar)
+    {
+      m.rttVar = rttVar;
+    }
+  else
+    {
+      m.rttVar = m.rttVar - (m.rttVar - rttVar) / 4;
+    }
+  m.minRtt = minRtt;
+  m.updated = Simulator::Now ();
+}
+
+uint32_t
+TcpMetricsCache::GetNEntries (void) const
+{
+  return static_cast<uint32_t> (m_lru.size ());
+}
+
+void
+TcpMetricsCache::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_lru.clear ();
+  m_index.clear ();
+}
+
+void
+TcpMetricsCache::SetMaxEntries (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  m_maxEntries = n;
+  Trim ();
+}
+
+uint32_t
+TcpMetricsCache::GetMaxEntries (void) const
+{
+  return m_maxEntries;
+}
+
+void
+TcpMetricsCache::Trim (void)
+{
+  while (m_lru.size () > m_maxEntries)
+    {
+      NS_LOG_LOGIC ("Evicting the metrics of " << m_lru.back ().first);
+      m_index.erase (m_lru.back ().first);
+      m_lru.pop_back ();
+    }
+}
+
+} // namespace ns3
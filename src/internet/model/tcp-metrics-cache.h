@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef TCP_METRICS_CACHE_H
+#define TCP_METRICS_CACHE_H
+
+#include <stdint.h>
+#include <list>
+#include <map>
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/address.h"
+
+namespace ns3 {
+
+class Node;
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Per-destination cache of the RTT of past connections
+ *
+ * As tcp_metrics in Linux, the smoothed RTT, its variation and the minimum
+ * RTT of a connection are stored per peer address when the connection
+ * closes, and used to seed the RTT estimator of the next connections to
+ * the same peer, instead of the initial RTT.
+ *
+ * A stored value that is larger than the cached one replaces it; a smaller
+ * one only moves it down by 1/8 (SRTT) or 1/4 (RTTVAR) of the difference,
+ * as tcp_update_metrics () does, so that a single lucky connection does
+ * not make the next ones too aggressive.
+ *
+ * The cache is aggregated to the node, and shared by all its sockets.  Its
+ * size is bounded by MaxEntries, the least recently used entry being
+ * evicted first; entries not updated for Timeout are ignored and dropped.
+ */
+class TcpMetricsCache : public Object
+{
+public:
+  /**
+   * \brief Metrics of a destination
+   */
+  struct Metrics
+  {
+    Time srtt;    //!< Smoothed RTT
+    Time rttVar;  //!< Variation of the RTT
+    Time minRtt;  //!< Minimum RTT
+    Time updated; //!< Time of the last update
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpMetricsCache ();
+  virtual ~TcpMetricsCache ();
+
+  /**
+   * \brief Get the cache of a node, aggregating a new one if it has none
+   * \param node the node
+   * \return the cache of the node
+   */
+  static Ptr<TcpMetricsCache> GetOrCreate (Ptr<Node> node);
+
+  /**
+   * \brief Look up the metrics of a destination
+   *
+   * A hit makes the entry the most recently used one; an entry older than
+   * Timeout is dropped and reported as a miss.
+   *
+   * \param peer the address of the destination
+   * \param metrics where to copy the metrics, if found
+   * \return true if the destination was found
+   */
+  bool Lookup (const Address &peer, Metrics *metrics);
+
+  /**
+   * \brief Store the metrics of a connection to a destination
+   * \param peer the address of the destination
+   * \param srtt the smoothed RTT of the connection
+   * \param rttVar the variation of the RTT of the connection
+   * \param minRtt the minimum RTT of the connection
+   */
+  void Update (const Address &peer, Time srtt, Time rttVar, Time minRtt);
+
+  /**
+   * \brief Get the number of destinations in the cache
+   * \return the number of entries
+   */
+  uint32_t GetNEntries (void) const;
+
+  /**
+   * \brief Forget every destination
+   */
+  void Flush (void);
+
+private:
+  /**
+   * \brief Set the maximum number of entries, evicting the extra ones
+   * \param n the maximum number of entries, at least 1
+   */
+  void SetMaxEntries (uint32_t n);
+
+  /**
+   * \brief Get the maximum number of entries
+   * \return the maximum number of entries
+   */
+  uint32_t GetMaxEntries (void) const;
+
+  /**
+   * \brief Evict least recently used entries down to the maximum
+   */
+  void Trim (void);
+
+  typedef std::list<std::pair<Address, Metrics> > LruList; //!< Entries, most recently used first
+
+  LruList                              m_lru;        //!< Entries, most recently used first
+  std::map<Address, LruList::iterator> m_index;      //!< Entry of each destination
+  uint32_t                             m_maxEntries; //!< Maximum number of entries
+  Time                                 m_timeout;    //!< Age after which an entry is dropped
+};
+
+} // namespace ns3
+
+#endif /* TCP_METRICS_CACHE_H */
@@ -43,6 +43,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/data-rate.h"
 #include "ns3/object.h"
+#include "ns3/object-factory.h"
 #include "tcp-socket-base.h"
 #include "tcp-l4-protocol.h"
 #include "ipv4-end-point.h"
@@ -51,6 +52,8 @@
 #include "tcp-tx-buffer.h"
 #include "tcp-rx-buffer.h"
 #include "rtt-estimator.h"
+#include "rto-policy.h"
+#include "tcp-metrics-cache.h"
 #include "tcp-header.h"
 #include "tcp-option-winscale.h"
 #include "tcp-option-ts.h"
@@ -123,6 +126,24 @@ TcpSocketBase::GetTypeId (void)
                    MakeTimeAccessor (&TcpSocketBase::SetClockGranularity,
                                      &TcpSocketBase::GetClockGranularity),
                    MakeTimeChecker ())
+    .AddAttribute ("RtoPolicyType",
+                   "Type of the policy deriving the RTO from the RTT estimator",
+                   TypeIdValue (RtoRfc6298::GetTypeId ()),
+                   MakeTypeIdAccessor (&TcpSocketBase::SetRtoPolicyType,
+                                       &TcpSocketBase::GetRtoPolicyType),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("MinRttWindow",
+                   "Window of the filter of the minimum RTT, zero to keep the minimum of all samples",
+                   TimeValue (Seconds (10.0)),
+                   MakeTimeAccessor (&TcpSocketBase::SetMinRttWindow,
+                                     &TcpSocketBase::GetMinRttWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("UseMetricsCache",
+                   "Store the RTT of the connection per destination when it closes, "
+                   "and seed the RTT estimator of new connections with it",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_useMetricsCache),
+                   MakeBooleanChecker ())
     .AddAttribute ("TxBuffer",
                    "TCP Tx buffer",
                    PointerValue (),
@@ -147,6 +168,36 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_limitedTx),
                    MakeBooleanChecker ())
+    .AddAttribute ("PerSegmentRttSampling",
+                   "Take one RTT sample per newly acknowledged, never retransmitted "
+                   "segment instead of one per ACK, when the ACK carries no timestamp",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_perSegmentRtt),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Rack",
+                   "Enable RACK time-based loss detection (RFC 8985); requires SACK",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_rackEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Tlp",
+                   "Enable tail loss probes (RFC 8985)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_tlpEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LazyRetxTimer",
+                   "On a new ACK, only move the expiry of the retransmission "
+                   "timer and let its event re-arm itself when it fires early, "
+                   "instead of cancelling and scheduling the event again",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&TcpSocketBase::m_lazyRetxTimer),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UndoSpuriousRto",
+                   "Detect spurious RTOs, with Eifel (RFC 3522) if timestamps are "
+                   "in use and F-RTO (RFC 5682) otherwise, and restore cwnd and "
+                   "ssThresh after them",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_undoSpuriousRto),
+                   MakeBooleanChecker ())
     .AddAttribute ("UseEcn", "Parameter to set ECN functionality",
                    EnumValue (TcpSocketState::Off),
                    MakeEnumAccessor (&TcpSocketBase::SetUseEcn),
@@ -161,6 +212,14 @@ TcpSocketBase::GetTypeId (void)
                      "Last RTT sample",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_lastRttTrace),
                      "ns3::TracedValueCallback::Time")
+    .AddTraceSource ("RttSample",
+                     "RTT sample fed to the RTT estimator",
+                     MakeTraceSourceAccessor (&TcpSocketBase::m_rttSampleTrace),
+                     "ns3::Time::TracedCallback")
+    .AddTraceSource ("UndoneRtos",
+                     "Number of RTOs found spurious and undone",
+                     MakeTraceSourceAccessor (&TcpSocketBase::m_undoneRtos),
+                     "ns3::TracedValueCallback::Uint32")
     .AddTraceSource ("NextTxSequence",
                      "Next sequence number to send (SND.NXT)",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_nextTxSequenceTrace),
@@ -323,6 +382,7 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_delAckTimeout (sock.m_delAckTimeout),
     m_persistTimeout (sock.m_persistTimeout),
     m_cnTimeout (sock.m_cnTimeout),
+    m_perSegmentRtt (sock.m_perSegmentRtt),
     m_endPoint (nullptr),
     m_endPoint6 (nullptr),
     m_node (sock.m_node),
@@ -350,6 +410,10 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_recoverActive (sock.m_recoverActive),
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
+    m_lazyRetxTimer (sock.m_lazyRetxTimer),
+    m_rackEnabled (sock.m_rackEnabled),
+    m_tlpEnabled (sock.m_tlpEnabled),
+    m_undoSpuriousRto (sock.m_undoSpuriousRto),
     m_isFirstPartialAck (sock.m_isFirstPartialAck),
     m_txTrace (sock.m_txTrace),
     m_rxTrace (sock.m_rxTrace),
@@ -365,6 +429,12 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     {
       m_rtt = sock.m_rtt->Copy ();
     }
+  if (sock.m_rtoPolicy)
+    {
+      m_rtoPolicy = sock.m_rtoPolicy->Copy ();
+    }
+  m_minRttFilter = sock.m_minRttFilter;
+  m_useMetricsCache = sock.m_useMetricsCache;
   // Reset all callbacks to null
   Callback<void, Ptr< Socket > > vPS = MakeNullCallback<void, Ptr<Socket> > ();
   Callback<void, Ptr<Socket>, const Address &> vPSA = MakeNullCallback<void, Ptr<Socket>, const Address &> ();
@@ -488,6 +558,29 @@ void
 TcpSocketBase::SetRtt (Ptr<RttEstimator> rtt)
 {
   m_rtt = rtt;
+  m_rtoCacheValid = false;
+}
+
+void
+TcpSocketBase::SetRtoPolicy (Ptr<RtoPolicy> policy)
+{
+  NS_LOG_FUNCTION (this << policy);
+  m_rtoPolicy = policy;
+  m_rtoPolicy->SetMinRto (m_minRto);
+  m_rtoPolicy->SetClockGranularity (m_clockGranularity);
+  m_rtoCacheValid = false;
+}
+
+Ptr<RtoPolicy>
+TcpSocketBase::GetRtoPolicy (void) const
+{
+  return m_rtoPolicy;
+}
+
+uint32_t
+TcpSocketBase::GetUndoneRtoCount (void) const
+{
+  return m_undoneRtos;
 }
 
 /* Inherit from Socket class: Returns error code */
@@ -716,6 +809,8 @@ TcpSocketBase::Connect (const Address & address)
 
   // Re-initialize parameters in case this socket is being reused after CLOSE
   m_rtt->Reset ();
+  m_rtoPolicy->Reset ();
+  SeedFromMetricsCache ();
   m_synCount = m_synRetries;
   m_dataRetrCount = m_dataRetries;
 
@@ -1100,6 +1195,7 @@ TcpSocketBase::CloseAndNotify (void)
 
   if (!m_closeNotified)
     {
+      StoreMetrics ();
       NotifyNormalClose ();
       m_closeNotified = true;
     }
@@ -1375,7 +1471,7 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
     { // Zero window: Enter persist state to send 1 byte to probe
       NS_LOG_LOGIC (this << " Enter zerowindow persist state");
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + GetRetxDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
       NS_LOG_LOGIC ("Schedule persist timeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
@@ -1808,7 +1904,7 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
         }
     }
 
-  m_txBuffer->DiscardUpTo (ackNumber, MakeCallback (&TcpRateOps::SkbDelivered, m_rateOps));
+  m_txBuffer->DiscardUpTo (ackNumber, MakeCallback (&TcpSocketBase::SkbDelivered, this));
 
   uint32_t currentDelivered = static_cast<uint32_t> (m_rateOps->GetConnectionRate ().m_delivered - previousDelivered);
   m_tcb->m_lastAckedSackedBytes = currentDelivered;
@@ -1846,6 +1942,11 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       m_tcb->m_ecnState = TcpSocketState::ECN_IDLE;
     }
 
+  if (m_spuriousRtoState != SPURIOUS_RTO_NONE)
+    {
+      DetectSpuriousRto (tcpHeader, ackNumber, oldHeadSequence);
+    }
+
   // Update bytes in flight before processing the ACK for proper calculation of congestion window
   NS_LOG_INFO ("Update bytes in flight before processing the ACK.");
   BytesInFlight ();
@@ -1855,6 +1956,9 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
   ProcessAck (ackNumber, (bytesSacked > 0), currentDelivered, oldHeadSequence);
   m_tcb->m_isRetransDataAcked = false;
 
+  // RFC 8985, Section 6.2: time-based loss detection on every ACK
+  RackDetectLoss (currentDelivered);
+
   if (m_congestionControl->HasCongControl ())
     {
       uint32_t currentLost = m_txBuffer->GetLost ();
@@ -2609,6 +2713,7 @@ TcpSocketBase::DoPeerClose (void)
       // until all its existing data are pushed into the TCP socket, then call Close()
       // explicitly.
       NS_LOG_LOGIC ("TCP " << this << " calling NotifyNormalClose");
+      StoreMetrics ();
       NotifyNormalClose ();
       m_closeNotified = true;
     }
@@ -2624,7 +2729,7 @@ TcpSocketBase::DoPeerClose (void)
     {
       m_dataRetrCount = m_dataRetries; // prevent endless FINs
       NS_LOG_LOGIC ("TcpSocketBase " << this << " scheduling LATO1");
-      Time lastRto = m_rtt->GetEstimate () + Max (m_clockGranularity, m_rtt->GetVariation () * 4);
+      Time lastRto = GetUnclampedRto ();
       m_lastAckEvent = Simulator::Schedule (lastRto, &TcpSocketBase::LastAckTimeout, this);
     }
 }
@@ -2641,7 +2746,7 @@ TcpSocketBase::Destroy (void)
       m_tcp->RemoveSocket (this);
     }
   NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                (Simulator::Now () + GetRetxDelayLeft ()).GetSeconds ());
   CancelAllTimers ();
 }
 
@@ -2657,7 +2762,7 @@ TcpSocketBase::Destroy6 (void)
       m_tcp->RemoveSocket (this);
     }
   NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                (Simulator::Now () + GetRetxDelayLeft ()).GetSeconds ());
   CancelAllTimers ();
 }
 
@@ -2704,7 +2809,7 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
   AddOptions (header);
 
   // RFC 6298, clause 2.4
-  m_rto = Max (m_rtt->GetEstimate () + Max (m_clockGranularity, m_rtt->GetVariation () * 4), m_minRto);
+  m_rto = GetRto ();
 
   uint16_t windowSize = AdvertisedWindowSize ();
   bool hasSyn = flags & TcpHeader::SYN;
@@ -2726,6 +2831,7 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
         { // No more connection retries, give up
           NS_LOG_LOGIC ("Connection failed.");
           m_rtt->Reset (); //According to recommendation -> RFC 6298
+          m_rtoPolicy->Reset ();
           NotifyConnectionFailed ();
           m_state = CLOSED;
           DeallocateEndPoint ();
@@ -2738,13 +2844,17 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
           m_synCount--;
         }
 
+      // The SYN takes one sequence number: record it as such, so that a
+      // retransmission finds its entry and the sample is dropped (Karn),
+      // while the SYN+ACK or the ACK of the first one gives the first RTT
+      // sample of the connection (RFC 6298, clause 2.2)
       if (m_synRetries - 1 == m_synCount)
         {
-          UpdateRttHistory (s, 0, false);
+          UpdateRttHistory (s, 1, false);
         }
       else
         { // This is SYN retransmission
-          UpdateRttHistory (s, 0, true);
+          UpdateRttHistory (s, 1, true);
         }
 
       windowSize = AdvertisedWindowSize (false);
@@ -2786,6 +2896,7 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
                     << Simulator::Now ().GetSeconds () << " to expire at time "
                     << (Simulator::Now () + m_rto.Get ()).GetSeconds ());
       m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::SendEmptyPacket, this, flags);
+      m_retxExpiry = Seconds (0.0); // Not the lazily re-armed timer
     }
 }
 
@@ -2911,6 +3022,7 @@ TcpSocketBase::CompleteFork (Ptr<Packet> p, const TcpHeader& h,
       m_endPoint = nullptr;
     }
   m_tcp->AddSocket (this);
+  SeedFromMetricsCache ();
 
   // Change the cloned socket from LISTEN state to SYN_RCVD
   NS_LOG_DEBUG ("LISTEN -> SYN_RCVD");
@@ -3128,7 +3240,12 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
       NS_LOG_LOGIC (this << " SendDataPacket Schedule ReTxTimeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_rto.Get ()).GetSeconds () );
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+      ArmRetxTimer (m_rto);
+    }
+
+  if (!isRetransmission)
+    { // RFC 8985, Section 7.2: restart the probe timer on new data
+      ArmTlpTimer ();
     }
 
   m_txTrace (p, header, this);
@@ -3178,18 +3295,24 @@ TcpSocketBase::UpdateRttHistory (const SequenceNumber32 &seq, uint32_t sz,
   // update the history of sequence numbers used to calculate the RTT
   if (isRetransmission == false)
     { // This is the next expected one, just log at end
-      m_history.push_back (RttHistory (seq, sz, Simulator::Now ()));
+      if (m_history.GetSize () == m_history.GetCapacity ())
+        { // Make room for a full window, or double the room if it is exceeded
+          m_history.Reserve (std::max (2 * m_history.GetCapacity (),
+                                       m_tcb->m_cWnd.Get () / m_tcb->m_segmentSize + 1));
+        }
+      m_history.PushBack (RttHistory (seq, sz, Simulator::Now ()));
+      m_historyMaxCount = std::max (m_historyMaxCount, sz);
     }
   else
     { // This is a retransmit, find in list and mark as re-tx
-      for (std::deque<RttHistory>::iterator i = m_history.begin (); i != m_history.end (); ++i)
-        {
-          if ((seq >= i->seq) && (seq < (i->seq + SequenceNumber32 (i->count))))
-            { // Found it
-              i->retx = true;
-              i->count = ((seq + SequenceNumber32 (sz)) - i->seq); // And update count in hist
-              break;
-            }
+      // No entry spans more than m_historyMaxCount bytes
+      RttHistory *h = m_history.Find (seq, m_historyMaxCount);
+      if (h != nullptr)
+        { // Found it
+          h->retx = true;
+          h->count = ((seq + SequenceNumber32 (sz)) - h->seq); // And update count in hist
+          h->time = Simulator::Now (); // RACK needs the last transmission time
+          m_historyMaxCount = std::max (m_historyMaxCount, h->count);
         }
     }
 }
@@ -3527,12 +3650,17 @@ TcpSocketBase::EstimateRtt (const TcpHeader& tcpHeader)
   SequenceNumber32 ackSeq = tcpHeader.GetAckNumber ();
   Time m = Time (0.0);
 
+  // With timestamps the echoed value identifies a single segment, so
+  // per-segment sampling only applies to ACKs without them
+  bool perSegment = m_perSegmentRtt
+    && !(m_timestampEnabled && tcpHeader.HasOption (TcpOption::TS));
+
   // An ack has been received, calculate rtt and log this measurement
   // Note we use a linear search (O(n)) for this since for the common
   // case the ack'ed packet will be at the head of the list
-  if (!m_history.empty ())
+  if (!perSegment && !m_history.IsEmpty ())
     {
-      RttHistory& h = m_history.front ();
+      RttHistory& h = m_history.Front ();
       if (!h.retx && ackSeq >= (h.seq + SequenceNumber32 (h.count)))
         { // Ok to use this sample
           if (m_timestampEnabled && tcpHeader.HasOption (TcpOption::TS))
@@ -3554,23 +3682,47 @@ TcpSocketBase::EstimateRtt (const TcpHeader& tcpHeader)
     }
 
   // Now delete all ack history with seq <= ack
-  while (!m_history.empty ())
+  m_rttSamples.clear ();
+  while (!m_history.IsEmpty ())
     {
-      RttHistory& h = m_history.front ();
+      RttHistory& h = m_history.Front ();
       if ((h.seq + SequenceNumber32 (h.count)) > ackSeq)
         {
           break;                                                              // Done removing
         }
-      m_history.pop_front (); // Remove
+      if (perSegment && !h.retx && Simulator::Now () > h.time)
+        { // Karn's algorithm: only never retransmitted segments are sampled
+          m_rttSamples.push_back (Simulator::Now () - h.time);
+        }
+      m_history.PopFront (); // Remove
     }
 
+  bool measured = false;
+  Time estimate = m_rtt->GetEstimate ();
   if (!m.IsZero ())
     {
+      m_rttSampleTrace (m);
       m_rtt->Measurement (m);                // Log the measurement
+      m_rtoPolicy->AddSample (m, estimate);
+      measured = true;
+    }
+  else if (!m_rttSamples.empty ())
+    {
+      m_rtt->MeasurementBatch (m_rttSamples.data (), m_rttSamples.size ());
+      for (const Time &sample : m_rttSamples)
+        {
+          m_rttSampleTrace (sample);
+          m_rtoPolicy->AddSample (sample, estimate);
+        }
+      measured = true;
+    }
+
+  if (measured)
+    {
       // RFC 6298, clause 2.4
-      m_rto = Max (m_rtt->GetEstimate () + Max (m_clockGranularity, m_rtt->GetVariation () * 4), m_minRto);
+      m_rto = GetRto ();
       m_tcb->m_lastRtt = m_rtt->GetEstimate ();
-      m_tcb->m_minRtt = std::min (m_tcb->m_lastRtt.Get (), m_tcb->m_minRtt);
+      m_tcb->m_minRtt = m_minRttFilter.Update (Simulator::Now (), m_tcb->m_lastRtt.Get ());
       NS_LOG_INFO (this << m_tcb->m_lastRtt << m_tcb->m_minRtt);
     }
 }
@@ -3588,17 +3740,14 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
 
   if (m_state != SYN_RCVD && resetRTO)
     { // Set RTO unless the ACK is received in SYN_RCVD state
-      NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
-      m_retxEvent.Cancel ();
       // On receiving a "New" ack we restart retransmission timer .. RFC 6298
       // RFC 6298, clause 2.4
-      m_rto = Max (m_rtt->GetEstimate () + Max (m_clockGranularity, m_rtt->GetVariation () * 4), m_minRto);
+      m_rto = GetRto ();
 
-      NS_LOG_LOGIC (this << " Schedule ReTxTimeout at time " <<
+      NS_LOG_LOGIC (this << " Restart ReTxTimeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_rto.Get ()).GetSeconds ());
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+      ArmRetxTimer (m_rto);
     }
 
   // Note the highest ACK and tell app to send more
@@ -3616,9 +3765,13 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
   if (m_txBuffer->Size () == 0 && m_state != FIN_WAIT_1 && m_state != CLOSING)
     { // No retransmit timer if no data to retransmit
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + GetRetxDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
     }
+
+  // RFC 8985, Section 7.2: an ACK ends the probe and restarts its timer
+  m_tlpInFlight = false;
+  ArmTlpTimer ();
 }
 
 // Retransmit timeout
@@ -3688,6 +3841,22 @@ TcpSocketBase::ReTxTimeout ()
       m_txBuffer->ResetRenoSack ();
     }
 
+  // RFC 5682, Section 2.1, step 1 and RFC 3522: only the first timeout
+  // of a window is checked for spuriousness; keep what its response
+  // changes, and the timestamp its retransmission carries
+  bool detectSpurious = m_undoSpuriousRto && m_tcb->m_congState != TcpSocketState::CA_LOSS;
+  if (detectSpurious)
+    {
+      m_undoCwnd = m_tcb->m_cWnd;
+      m_undoSsThresh = m_tcb->m_ssThresh;
+      m_undoTsVal = TcpOptionTS::NowToTsValue ();
+      m_spuriousRtoState = m_timestampEnabled ? SPURIOUS_RTO_EIFEL : SPURIOUS_RTO_FRTO_FIRST;
+    }
+  else
+    {
+      m_spuriousRtoState = SPURIOUS_RTO_NONE;
+    }
+
   // From RFC 6675, Section 5.1
   // [RFC2018] suggests that a TCP sender SHOULD expunge the SACK
   // information gathered from a receiver upon a retransmission timeout
@@ -3700,7 +3869,16 @@ TcpSocketBase::ReTxTimeout ()
   // The head of the sent list will not be marked as sacked, therefore
   // will be retransmitted, if the receiver renegotiate the SACK blocks
   // that we received.
-  m_txBuffer->SetSentListLost (resetSack);
+  // RFC 4015, Section 3: until the timeout is known to be genuine, only
+  // the head is retransmitted (see ConfirmRto)
+  if (detectSpurious)
+    {
+      m_txBuffer->MarkHeadAsLost ();
+    }
+  else
+    {
+      m_txBuffer->SetSentListLost (resetSack);
+    }
 
   // From RFC 6675, Section 5.1
   // If an RTO occurs during loss recovery as specified in this document,
@@ -3710,12 +3888,17 @@ TcpSocketBase::ReTxTimeout ()
   m_recover = m_tcb->m_highTxMark;
   m_recoverActive = true;
 
-  // RFC 6298, clause 2.5, double the timer
-  Time doubledRto = m_rto + m_rto;
-  m_rto = Min (doubledRto, Time::FromDouble (60,  Time::S));
+  // RFC 6298, clause 2.5, back off the timer
+  m_rto = m_rtoPolicy->Backoff (m_rto);
 
   // Empty RTT history
-  m_history.clear ();
+  m_history.Clear ();
+  m_historyMaxCount = 0;
+
+  // The RTO recovery takes over from RACK-TLP
+  m_rackEvent.Cancel ();
+  m_tlpEvent.Cancel ();
+  m_tlpInFlight = false;
 
   // Please don't reset highTxMark, it is used for retransmission detection
 
@@ -3741,6 +3924,14 @@ TcpSocketBase::ReTxTimeout ()
                 m_txBuffer->HeadSequence () << " doubled rto to " <<
                 m_rto.Get ().GetSeconds () << " s");
 
+  if (detectSpurious)
+    {
+      // The rest of the window is still deemed in flight: retransmit
+      // the head regardless of cwnd
+      DoRetransmit ();
+      return;
+    }
+
   NS_ASSERT_MSG (BytesInFlight () == 0, "There are some bytes in flight after an RTO: " <<
                  BytesInFlight ());
 
@@ -3751,6 +3942,107 @@ TcpSocketBase::ReTxTimeout ()
                  ") there is more than one segment (" << m_tcb->m_segmentSize << ")");
 }
 
+void
+TcpSocketBase::DetectSpuriousRto (const TcpHeader& tcpHeader, const SequenceNumber32 &ackNumber,
+                                  const SequenceNumber32 &oldHeadSequence)
+{
+  NS_LOG_FUNCTION (this << ackNumber << oldHeadSequence);
+  bool advanced = ackNumber > oldHeadSequence;
+
+  switch (m_spuriousRtoState)
+    {
+    case SPURIOUS_RTO_EIFEL:
+      if (!advanced)
+        {
+          return;
+        }
+      // RFC 3522, Section 3.2: the ACK was sent for the original
+      // transmission if it echoes an older timestamp than the one of
+      // the retransmission
+      if (tcpHeader.HasOption (TcpOption::TS)
+          && m_tcb->m_rcvTimestampEchoReply < m_undoTsVal)
+        {
+          UndoSpuriousRto ();
+        }
+      else
+        {
+          ConfirmRto ();
+        }
+      break;
+
+    case SPURIOUS_RTO_FRTO_FIRST:
+      // RFC 5682, Section 2.1, step 2
+      if (advanced && ackNumber < m_recover
+          && m_txBuffer->SizeFromSequence (m_tcb->m_highTxMark) > 0)
+        {
+          // (2.b) send up to two new segments, and wait for the next ACK
+          for (uint32_t i = 0; i < 2; ++i)
+            {
+              uint32_t s = std::min (m_txBuffer->SizeFromSequence (m_tcb->m_highTxMark),
+                                     m_tcb->m_segmentSize);
+              if (s == 0 || (m_highRxAckMark.Get () + SequenceNumber32 (m_rWnd))
+                  < (m_tcb->m_highTxMark.Get () + SequenceNumber32 (s)))
+                {
+                  break;
+                }
+              NS_LOG_DEBUG ("F-RTO: sending new data at " << m_tcb->m_highTxMark);
+              SendDataPacket (m_tcb->m_highTxMark, s, m_connected);
+            }
+          m_spuriousRtoState = SPURIOUS_RTO_FRTO_SECOND;
+        }
+      else
+        {
+          // (2.a) duplicate ACK, whole window acknowledged, or no new data
+          ConfirmRto ();
+        }
+      break;
+
+    case SPURIOUS_RTO_FRTO_SECOND:
+      // RFC 5682, Section 2.1, step 3: an ACK advancing SND.UNA for
+      // segments that were not retransmitted (3.b), or a duplicate (3.a)
+      if (advanced)
+        {
+          UndoSpuriousRto ();
+        }
+      else
+        {
+          ConfirmRto ();
+        }
+      break;
+
+    default:
+      break;
+    }
+}
+
+void
+TcpSocketBase::UndoSpuriousRto (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_spuriousRtoState = SPURIOUS_RTO_NONE;
+
+  // RFC 4015, Section 4: revert the congestion control state
+  m_tcb->m_cWnd = std::max (m_tcb->m_cWnd.Get (), m_undoCwnd);
+  m_tcb->m_cWndInfl = m_tcb->m_cWnd;
+  m_tcb->m_ssThresh = std::max (m_tcb->m_ssThresh.Get (), m_undoSsThresh);
+  m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
+  m_tcb->m_congState = TcpSocketState::CA_OPEN;
+  m_recoverActive = false;
+  ++m_undoneRtos;
+
+  NS_LOG_DEBUG ("Spurious RTO, restored cwnd to " << m_tcb->m_cWnd <<
+                " and ssthresh to " << m_tcb->m_ssThresh);
+}
+
+void
+TcpSocketBase::ConfirmRto (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_spuriousRtoState = SPURIOUS_RTO_NONE;
+  m_txBuffer->SetSentListLost (!m_sackEnabled);
+  NS_LOG_DEBUG ("RTO was not spurious, marked the window as lost");
+}
+
 void
 TcpSocketBase::DelAckTimeout (void)
 {
@@ -3785,7 +4077,7 @@ TcpSocketBase::LastAckTimeout (void)
       m_dataRetrCount--;
       SendEmptyPacket (TcpHeader::FIN | TcpHeader::ACK);
       NS_LOG_LOGIC ("TcpSocketBase " << this << " rescheduling LATO1");
-      Time lastRto = m_rtt->GetEstimate () + Max (m_clockGranularity, m_rtt->GetVariation () * 4);
+      Time lastRto = GetUnclampedRto ();
       m_lastAckEvent = Simulator::Schedule (lastRto, &TcpSocketBase::LastAckTimeout, this);
     }
 }
@@ -3880,6 +4172,301 @@ TcpSocketBase::DoRetransmit ()
   NS_ASSERT (sz > 0);
 }
 
+void
+TcpSocketBase::SkbDelivered (TcpTxItem *item)
+{
+  m_rateOps->SkbDelivered (item);
+  if (!m_rackEnabled)
+    {
+      return;
+    }
+  // RFC 8985, Section 6.2, step 2: RACK follows the most recently sent
+  // delivered segment.  The RTT of a retransmission shorter than the
+  // minimum RTT is likely that of the original transmission, skip it.
+  Time xmitTs = item->GetLastSent ();
+  Time rtt = Simulator::Now () - xmitTs;
+  if (item->IsRetrans () && rtt < m_tcb->m_minRtt)
+    {
+      return;
+    }
+  if (xmitTs >= m_rackXmitTs)
+    {
+      m_rackXmitTs = xmitTs;
+      m_rackRtt = rtt;
+    }
+}
+
+void
+TcpSocketBase::RackDetectLoss (uint32_t currentDelivered)
+{
+  NS_LOG_FUNCTION (this << currentDelivered);
+  // RACK relies on SACK to learn about segments delivered out of order
+  if (!m_rackEnabled || !m_sackEnabled || m_history.IsEmpty () || m_rackXmitTs.IsZero ()
+      || m_tcb->m_congState == TcpSocketState::CA_LOSS)
+    {
+      return;
+    }
+
+  // Only the head is checked, not every segment sent before RACK.xmit_ts
+  // as in RFC 8985, Section 6.2, step 5: the head is the one segment the
+  // scoreboard cannot have SACKed, and the only one TcpTxBuffer can mark
+  // as lost.  Once in recovery, the RFC 6675 scoreboard (NextSeg, IsLost)
+  // finds the other holes.
+  RttHistory& h = m_history.Front ();
+  if (h.count == 0 || h.time >= m_rackXmitTs)
+    {
+      // Not sent before any delivered segment: no evidence of loss
+      m_rackEvent.Cancel ();
+      return;
+    }
+
+  // RFC 8985, Section 6.2, step 4: reordering window of min_RTT / 4,
+  // bounded by SRTT
+  Time reoWnd = Seconds (0.0);
+  if (m_tcb->m_minRtt != Time::Max ())
+    {
+      reoWnd = Min (m_tcb->m_minRtt / 4, m_rtt->GetEstimate ());
+    }
+  Time deadline = h.time + m_rackRtt + reoWnd;
+  m_rackEvent.Cancel ();
+  if (Simulator::Now () < deadline)
+    {
+      m_rackEvent = Simulator::Schedule (deadline - Simulator::Now (),
+                                         &TcpSocketBase::RackTimeout, this);
+      return;
+    }
+
+  NS_LOG_DEBUG ("RACK: segment " << h.seq << " sent at " << h.time <<
+                " is lost, RACK.xmit_ts " << m_rackXmitTs << " RACK.rtt " << m_rackRtt);
+  if (m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
+    {
+      if (h.retx && !m_txBuffer->IsLost (m_txBuffer->HeadSequence ()))
+        {
+          // Lost retransmission: mark the head as lost, NextSeg () returns
+          // it first and SendPendingData () sends it again within cwnd,
+          // rWnd and pacing.  The first reduction was not enough, so this
+          // is a new congestion event, with a new RecoveryPoint.
+          m_txBuffer->MarkHeadAsLost ();
+          m_recover = m_tcb->m_highTxMark;
+          m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb, BytesInFlight ());
+          if (!m_congestionControl->HasCongControl ())
+            {
+              m_recoveryOps->EnterRecovery (m_tcb, m_dupAckCount, UnAckDataCount (), currentDelivered);
+            }
+          NS_LOG_INFO ("Lost retransmission of " << m_txBuffer->HeadSequence () <<
+                       ", cwnd " << m_tcb->m_cWnd << ", ssthresh " << m_tcb->m_ssThresh <<
+                       ", recovery point " << m_recover);
+        }
+    }
+  else if (m_tcb->m_congState == TcpSocketState::CA_OPEN
+           || m_tcb->m_congState == TcpSocketState::CA_DISORDER)
+    {
+      // RFC 6675, Section 5.1: no new recovery before RecoveryPoint
+      if (!m_recoverActive || m_highRxAckMark >= m_recover)
+        {
+          EnterRecovery (currentDelivered);
+        }
+    }
+}
+
+void
+TcpSocketBase::RackTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  RackDetectLoss (0);
+  SendPendingData (m_connected);
+}
+
+void
+TcpSocketBase::ArmTlpTimer (void)
+{
+  if (!m_tlpEnabled || m_tlpInFlight)
+    {
+      return;
+    }
+  m_tlpEvent.Cancel ();
+  if (m_tcb->m_congState != TcpSocketState::CA_OPEN
+      || (m_state != ESTABLISHED && m_state != CLOSE_WAIT)
+      || m_tcb->m_highTxMark.Get () <= m_txBuffer->HeadSequence ())
+    {
+      return;
+    }
+
+  Time pto = Seconds (1.0); // RFC 8985, Section 7.2: without SRTT
+  if (m_rtt->GetNSamples () > 0)
+    {
+      pto = m_rtt->GetEstimate () * 2;
+      uint32_t outstanding = static_cast<uint32_t> (m_tcb->m_highTxMark.Get () - m_txBuffer->HeadSequence ());
+      if (outstanding <= m_tcb->m_segmentSize)
+        { // Let the peer's delayed ACK timer fire first
+          pto += m_delAckTimeout;
+        }
+    }
+  if (m_retxEvent.IsRunning ())
+    {
+      pto = Min (pto, GetRetxDelayLeft ());
+    }
+  m_tlpEvent = Simulator::Schedule (pto, &TcpSocketBase::TlpTimeout, this);
+}
+
+void
+TcpSocketBase::TlpTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_tcb->m_congState != TcpSocketState::CA_OPEN
+      || m_tcb->m_highTxMark.Get () <= m_txBuffer->HeadSequence ())
+    {
+      return;
+    }
+  m_tlpInFlight = true;
+
+  uint32_t s = std::min (m_txBuffer->SizeFromSequence (m_tcb->m_nextTxSequence),
+                         m_tcb->m_segmentSize);
+  if (s > 0 && (m_highRxAckMark.Get () + SequenceNumber32 (m_rWnd)) >= (m_tcb->m_nextTxSequence.Get () + SequenceNumber32 (s)))
+    {
+      NS_LOG_DEBUG ("TLP: sending new data at " << m_tcb->m_nextTxSequence);
+      uint32_t sz = SendDataPacket (m_tcb->m_nextTxSequence, s, m_connected);
+      m_tcb->m_nextTxSequence += sz;
+    }
+  else
+    {
+      SequenceNumber32 seq = std::max (m_txBuffer->HeadSequence (),
+                                       m_tcb->m_highTxMark.Get () - static_cast<int32_t> (m_tcb->m_segmentSize));
+      NS_LOG_DEBUG ("TLP: retransmitting the last segment at " << seq);
+      SendDataPacket (seq, static_cast<uint32_t> (m_tcb->m_highTxMark.Get () - seq), m_connected);
+    }
+
+  // RFC 8985, Section 7.3: restart the RTO timer after the probe
+  ArmRetxTimer (m_rto);
+}
+
+void
+TcpSocketBase::UpdateRtoCache (void)
+{
+  Time estimate = m_rtt->GetEstimate ();
+  Time variation = m_rtt->GetVariation ();
+  uint32_t version = m_rtoPolicy->GetVersion ();
+  if (m_rtoCacheValid && estimate == m_rtoCacheEstimate && variation == m_rtoCacheVariation
+      && version == m_rtoCacheVersion)
+    {
+      return;
+    }
+  m_rtoCacheEstimate = estimate;
+  m_rtoCacheVariation = variation;
+  m_rtoCacheVersion = version;
+  m_rtoCacheUnclamped = m_rtoPolicy->ComputeRto (m_rtt);
+  m_rtoCacheRto = m_rtoPolicy->Clamp (m_rtoCacheUnclamped);
+  m_rtoCacheValid = true;
+}
+
+bool
+TcpSocketBase::GetPeerIpAddress (Address *peer) const
+{
+  if (m_endPoint != nullptr)
+    {
+      *peer = m_endPoint->GetPeerAddress ();
+      return true;
+    }
+  if (m_endPoint6 != nullptr)
+    {
+      *peer = m_endPoint6->GetPeerAddress ();
+      return true;
+    }
+  return false;
+}
+
+void
+TcpSocketBase::SeedFromMetricsCache (void)
+{
+  NS_LOG_FUNCTION (this);
+  Address peer;
+  TcpMetricsCache::Metrics metrics;
+  if (!m_useMetricsCache || !GetPeerIpAddress (&peer)
+      || !TcpMetricsCache::GetOrCreate (m_node)->Lookup (peer, &metrics))
+    {
+      return;
+    }
+  NS_LOG_LOGIC ("Seeding the RTT from the cache: srtt " << metrics.srtt
+                << " rttvar " << metrics.rttVar << " min " << metrics.minRtt);
+  m_rtt->Seed (metrics.srtt, metrics.rttVar);
+  // Replaced by the filtered minimum at the first sample
+  m_tcb->m_minRtt = metrics.minRtt;
+  m_rto = GetRto ();
+}
+
+void
+TcpSocketBase::StoreMetrics (void)
+{
+  NS_LOG_FUNCTION (this);
+  Address peer;
+  if (!m_useMetricsCache || m_rtt->GetNSamples () == 0 || !GetPeerIpAddress (&peer))
+    {
+      return;
+    }
+  TcpMetricsCache::GetOrCreate (m_node)->Update (peer, m_rtt->GetEstimate (),
+                                                 m_rtt->GetVariation (),
+                                                 m_tcb->m_minRtt);
+}
+
+Time
+TcpSocketBase::GetRto (void)
+{
+  UpdateRtoCache ();
+  return m_rtoCacheRto;
+}
+
+Time
+TcpSocketBase::GetUnclampedRto (void)
+{
+  UpdateRtoCache ();
+  return m_rtoCacheUnclamped;
+}
+
+void
+TcpSocketBase::ArmRetxTimer (Time delay)
+{
+  Time expiry = Simulator::Now () + delay;
+  if (m_lazyRetxTimer && m_retxEvent.IsRunning () && !m_retxExpiry.IsZero ()
+      && expiry >= Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent))
+    {
+      // The scheduled event fires first: just move the expiry, the event
+      // will re-arm itself for the remaining time
+      m_retxExpiry = expiry;
+      return;
+    }
+  m_retxEvent.Cancel ();
+  m_retxExpiry = expiry;
+  m_retxEvent = Simulator::Schedule (delay, &TcpSocketBase::RetxTimerExpired, this);
+}
+
+void
+TcpSocketBase::RetxTimerExpired (void)
+{
+  if (Simulator::Now () < m_retxExpiry)
+    {
+      NS_LOG_LOGIC (this << " ReTxTimeout moved to " << m_retxExpiry.GetSeconds ());
+      m_retxEvent = Simulator::Schedule (m_retxExpiry - Simulator::Now (),
+                                         &TcpSocketBase::RetxTimerExpired, this);
+      return;
+    }
+  m_retxExpiry = Seconds (0.0);
+  ReTxTimeout ();
+}
+
+Time
+TcpSocketBase::GetRetxDelayLeft (void) const
+{
+  if (!m_retxEvent.IsRunning ())
+    {
+      return Seconds (0.0);
+    }
+  if (m_retxExpiry.IsZero ())
+    {
+      return Simulator::GetDelayLeft (m_retxEvent);
+    }
+  return m_retxExpiry - Simulator::Now ();
+}
+
 void
 TcpSocketBase::CancelAllTimers ()
 {
@@ -3890,6 +4477,8 @@ TcpSocketBase::CancelAllTimers ()
   m_timewaitEvent.Cancel ();
   m_sendPendingDataEvent.Cancel ();
   m_pacingTimer.Cancel ();
+  m_rackEvent.Cancel ();
+  m_tlpEvent.Cancel ();
 }
 
 /* Move TCP to Time_Wait state and schedule a transition to Closed state */
@@ -3904,6 +4493,7 @@ TcpSocketBase::TimeWait ()
       // Technically the connection is not fully closed, but we notify now
       // because an implementation (real socket) would behave as if closed.
       // Notify normal close when entering TIME_WAIT or leaving LAST_ACK.
+      StoreMetrics ();
       NotifyNormalClose ();
       m_closeNotified = true;
     }
@@ -4163,7 +4753,7 @@ TcpSocketBase::ProcessOptionSack (const Ptr<const TcpOption> option)
   NS_LOG_FUNCTION (this << option);
 
   Ptr<const TcpOptionSack> s = DynamicCast<const TcpOptionSack> (option);
-  return m_txBuffer->Update (s->GetSackList (), MakeCallback (&TcpRateOps::SkbDelivered, m_rateOps));
+  return m_txBuffer->Update (s->GetSackList (), MakeCallback (&TcpSocketBase::SkbDelivered, this));
 }
 
 void
@@ -4309,6 +4899,11 @@ TcpSocketBase::SetMinRto (Time minRto)
 {
   NS_LOG_FUNCTION (this << minRto);
   m_minRto = minRto;
+  if (m_rtoPolicy)
+    {
+      m_rtoPolicy->SetMinRto (minRto);
+    }
+  m_rtoCacheValid = false;
 }
 
 Time
@@ -4322,6 +4917,11 @@ TcpSocketBase::SetClockGranularity (Time clockGranularity)
 {
   NS_LOG_FUNCTION (this << clockGranularity);
   m_clockGranularity = clockGranularity;
+  if (m_rtoPolicy)
+    {
+      m_rtoPolicy->SetClockGranularity (clockGranularity);
+    }
+  m_rtoCacheValid = false;
 }
 
 Time
@@ -4330,6 +4930,34 @@ TcpSocketBase::GetClockGranularity (void) const
   return m_clockGranularity;
 }
 
+void
+TcpSocketBase::SetRtoPolicyType (TypeId tid)
+{
+  NS_LOG_FUNCTION (this << tid);
+  ObjectFactory factory;
+  factory.SetTypeId (tid);
+  SetRtoPolicy (factory.Create<RtoPolicy> ());
+}
+
+TypeId
+TcpSocketBase::GetRtoPolicyType (void) const
+{
+  return m_rtoPolicy ? m_rtoPolicy->GetInstanceTypeId () : RtoRfc6298::GetTypeId ();
+}
+
+void
+TcpSocketBase::SetMinRttWindow (Time window)
+{
+  NS_LOG_FUNCTION (this << window);
+  m_minRttFilter.SetWindow (window);
+}
+
+Time
+TcpSocketBase::GetMinRttWindow (void) const
+{
+  return m_minRttFilter.GetWindow ();
+}
+
 Ptr<TcpTxBuffer>
 TcpSocketBase::GetTxBuffer (void) const
 {
@@ -4557,6 +5185,14 @@ TcpSocketBase::GetHighRxAck (void) const
 
 
 //RttHistory methods
+RttHistory::RttHistory ()
+  : seq (0),
+    count (0),
+    time (Seconds (0.0)),
+    retx (false)
+{
+}
+
 RttHistory::RttHistory (SequenceNumber32 s, uint32_t c, Time t)
   : seq (s),
     count (c),
@@ -4565,12 +5201,65 @@ RttHistory::RttHistory (SequenceNumber32 s, uint32_t c, Time t)
 {
 }
 
-RttHistory::RttHistory (const RttHistory& h)
-  : seq (h.seq),
-    count (h.count),
-    time (h.time),
-    retx (h.retx)
+//RttHistoryBuffer methods
+RttHistoryBuffer::RttHistoryBuffer ()
+{
+}
+
+void
+RttHistoryBuffer::Reserve (uint32_t n)
+{
+  uint32_t capacity = GetCapacity ();
+  if (n <= capacity)
+    {
+      return;
+    }
+  uint32_t newCapacity = 1;
+  while (newCapacity < n)
+    {
+      newCapacity <<= 1;
+    }
+  // Unwrap the entries at the start of the new storage
+  std::vector<RttHistory> buffer (newCapacity);
+  for (uint32_t i = 0; i < m_size; ++i)
+    {
+      buffer[i] = m_buffer[(m_head + i) & (capacity - 1)];
+    }
+  m_buffer.swap (buffer);
+  m_head = 0;
+}
+
+RttHistory*
+RttHistoryBuffer::Find (const SequenceNumber32 &seq, uint32_t maxCount)
 {
+  SequenceNumber32 from = seq - static_cast<int32_t> (maxCount);
+  uint32_t lo = 0;
+  uint32_t hi = m_size;
+  while (lo < hi)
+    {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (Get (mid).seq <= from)
+        {
+          lo = mid + 1;
+        }
+      else
+        {
+          hi = mid;
+        }
+    }
+  for (uint32_t i = lo; i < m_size; ++i)
+    {
+      RttHistory& h = Get (i);
+      if (seq < h.seq)
+        {
+          break;     // Not in the history
+        }
+      if (seq < (h.seq + SequenceNumber32 (h.count)))
+        {
+          return &h;
+        }
+    }
+  return nullptr;
 }
 
 } // namespace ns3
@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <queue>
+#include <vector>
 #include "ns3/traced-value.h"
 #include "ns3/tcp-socket.h"
 #include "ns3/ipv4-header.h"
@@ -32,6 +33,7 @@
 #include "ns3/data-rate.h"
 #include "ns3/node.h"
 #include "ns3/tcp-socket-state.h"
+#include "min-rtt-filter.h"
 
 namespace ns3 {
 
@@ -44,8 +46,10 @@ class TcpHeader;
 class TcpCongestionOps;
 class TcpRecoveryOps;
 class RttEstimator;
+class RtoPolicy;
 class TcpRxBuffer;
 class TcpTxBuffer;
+class TcpTxItem;
 class TcpOption;
 class Ipv4Interface;
 class Ipv6Interface;
@@ -59,6 +63,10 @@ class TcpRateOps;
 class RttHistory
 {
 public:
+  /**
+   * \brief Default constructor, used for the free slots of RttHistoryBuffer
+   */
+  RttHistory ();
   /**
    * \brief Constructor - builds an RttHistory with the given parameters
    * \param s First sequence number in packet sent
@@ -70,7 +78,13 @@ public:
    * \brief Copy constructor
    * \param h the object to copy
    */
-  RttHistory (const RttHistory& h); // Copy constructor
+  RttHistory (const RttHistory& h) = default;
+  /**
+   * \brief Copy assignment, used to fill the slots of RttHistoryBuffer
+   * \param h the object to copy
+   * \return this object
+   */
+  RttHistory& operator= (const RttHistory& h) = default;
 public:
   SequenceNumber32  seq;  //!< First sequence number in packet sent
   uint32_t        count;  //!< Number of bytes sent
@@ -78,6 +92,164 @@ public:
   bool            retx;   //!< True if this has been retransmitted
 };
 
+/**
+ * \ingroup tcp
+ *
+ * \brief FIFO of RttHistory entries, stored in a contiguous ring
+ *
+ * Entries are pushed at the back when segments are sent and popped from
+ * the front when they are acknowledged.  The ring is a power-of-two sized
+ * vector, so that slots are reused without allocating and indexes wrap
+ * with a mask; it only grows, geometrically, when it is full.
+ */
+class RttHistoryBuffer
+{
+public:
+  RttHistoryBuffer ();
+
+  /**
+   * \brief Check if the buffer holds no entry
+   * \return true if the buffer is empty
+   */
+  bool IsEmpty (void) const;
+
+  /**
+   * \brief Get the number of entries in the buffer
+   * \return the number of entries
+   */
+  uint32_t GetSize (void) const;
+
+  /**
+   * \brief Get the number of entries the buffer can hold without growing
+   * \return the capacity
+   */
+  uint32_t GetCapacity (void) const;
+
+  /**
+   * \brief Get the oldest entry; the buffer must not be empty
+   * \return the oldest entry
+   */
+  RttHistory& Front (void);
+
+  /**
+   * \brief Get the newest entry; the buffer must not be empty
+   * \return the newest entry
+   */
+  RttHistory& Back (void);
+
+  /**
+   * \brief Get an entry by position
+   * \param i position of the entry, 0 being the oldest
+   * \return the entry
+   */
+  RttHistory& Get (uint32_t i);
+
+  /**
+   * \brief Append an entry, growing the buffer if it is full
+   * \param h the entry
+   */
+  void PushBack (const RttHistory &h);
+
+  /**
+   * \brief Remove the oldest entry; the buffer must not be empty
+   */
+  void PopFront (void);
+
+  /**
+   * \brief Remove all the entries, keeping the storage
+   */
+  void Clear (void);
+
+  /**
+   * \brief Make room for at least n entries, keeping the current ones
+   *
+   * The capacity is rounded up to a power of two.
+   *
+   * \param n the number of entries to make room for
+   */
+  void Reserve (uint32_t n);
+
+  /**
+   * \brief Find the oldest entry covering a sequence number
+   *
+   * The entries must be sorted by starting sequence number, as they are
+   * pushed, and none may span more than maxCount bytes: the first entry
+   * that may reach seq is found by binary search, then the entries are
+   * scanned forward to the first one covering it.
+   *
+   * \param seq the sequence number
+   * \param maxCount upper bound of the count of the entries
+   * \return the entry, or nullptr if no entry covers seq
+   */
+  RttHistory* Find (const SequenceNumber32 &seq, uint32_t maxCount);
+
+private:
+  std::vector<RttHistory> m_buffer; //!< Storage, power-of-two sized
+  uint32_t m_head {0};              //!< Position of the oldest entry
+  uint32_t m_size {0};              //!< Number of entries
+};
+
+inline bool
+RttHistoryBuffer::IsEmpty (void) const
+{
+  return m_size == 0;
+}
+
+inline uint32_t
+RttHistoryBuffer::GetSize (void) const
+{
+  return m_size;
+}
+
+inline uint32_t
+RttHistoryBuffer::GetCapacity (void) const
+{
+  return static_cast<uint32_t> (m_buffer.size ());
+}
+
+inline RttHistory&
+RttHistoryBuffer::Front (void)
+{
+  return m_buffer[m_head];
+}
+
+inline RttHistory&
+RttHistoryBuffer::Back (void)
+{
+  return Get (m_size - 1);
+}
+
+inline RttHistory&
+RttHistoryBuffer::Get (uint32_t i)
+{
+  return m_buffer[(m_head + i) & (GetCapacity () - 1)];
+}
+
+inline void
+RttHistoryBuffer::PushBack (const RttHistory &h)
+{
+  if (m_size == GetCapacity ())
+    {
+      Reserve (m_size + 1);
+    }
+  m_buffer[(m_head + m_size) & (GetCapacity () - 1)] = h;
+  ++m_size;
+}
+
+inline void
+RttHistoryBuffer::PopFront (void)
+{
+  m_head = (m_head + 1) & (GetCapacity () - 1);
+  --m_size;
+}
+
+inline void
+RttHistoryBuffer::Clear (void)
+{
+  m_head = 0;
+  m_size = 0;
+}
+
 /**
  * \ingroup socket
  * \ingroup tcp
@@ -269,6 +441,28 @@ public:
    */
   virtual void SetRtt (Ptr<RttEstimator> rtt);
 
+  /**
+   * \brief Set the policy deriving the RTO from the RTT estimator.
+   *
+   * The minimum RTO and the clock granularity of the socket are passed
+   * on to the policy.
+   *
+   * \param policy the RTO policy
+   */
+  void SetRtoPolicy (Ptr<RtoPolicy> policy);
+
+  /**
+   * \brief Get the policy deriving the RTO from the RTT estimator.
+   * \return the RTO policy
+   */
+  Ptr<RtoPolicy> GetRtoPolicy (void) const;
+
+  /**
+   * \brief Get the number of RTOs found spurious and undone
+   * \return the number of undone RTOs
+   */
+  uint32_t GetUndoneRtoCount (void) const;
+
   /**
    * \brief Sets the Minimum RTO.
    * \param minRto The minimum RTO.
@@ -293,6 +487,30 @@ public:
    */
   Time GetClockGranularity (void) const;
 
+  /**
+   * \brief Set the RTO policy from its TypeId
+   * \param tid the TypeId of the RTO policy
+   */
+  void SetRtoPolicyType (TypeId tid);
+
+  /**
+   * \brief Get the TypeId of the RTO policy
+   * \return the TypeId of the RTO policy
+   */
+  TypeId GetRtoPolicyType (void) const;
+
+  /**
+   * \brief Set the window of the minimum RTT filter
+   * \param window the window, zero to keep the minimum of all samples
+   */
+  void SetMinRttWindow (Time window);
+
+  /**
+   * \brief Get the window of the minimum RTT filter
+   * \return the window
+   */
+  Time GetMinRttWindow (void) const;
+
   /**
    * \brief Get a pointer to the Tx buffer
    * \return a pointer to the tx buffer
@@ -367,6 +585,11 @@ public:
    */
   TracedCallback<Time, Time> m_lastRttTrace;
 
+  /**
+   * \brief Trace of the RTT samples fed to the estimator
+   */
+  TracedCallback<Time> m_rttSampleTrace;
+
   /**
    * \brief Callback function to hook to TcpSocketState pacing rate
    * \param oldValue old pacing rate value
@@ -1064,6 +1287,77 @@ protected:
    */
   virtual void ReTxTimeout (void);
 
+  /**
+   * \brief Get the RTO derived from the RTT estimator by the RTO policy
+   *
+   * The value is cached, and only computed again when the estimate or
+   * the variation of the estimator, the minimum RTO, the clock
+   * granularity or the policy change.
+   *
+   * \return the RTO, clamped by the policy
+   */
+  Time GetRto (void);
+
+  /**
+   * \brief Get the RTO derived from the RTT estimator by the RTO policy,
+   * without clamping
+   * \return the RTO
+   */
+  Time GetUnclampedRto (void);
+
+  /**
+   * \brief Compute the cached RTO values again if their inputs changed
+   *
+   * The inputs are the RTT estimate and variation, and the version of the
+   * RTO policy, which changes with its attributes.
+   */
+  void UpdateRtoCache (void);
+
+  /**
+   * \brief Get the IP address of the peer
+   * \param peer where to copy the address
+   * \return false if the socket has no endpoint
+   */
+  bool GetPeerIpAddress (Address *peer) const;
+
+  /**
+   * \brief Seed the RTT estimator and the minimum RTT from the metrics
+   * cached for the peer by past connections, if any
+   */
+  void SeedFromMetricsCache (void);
+
+  /**
+   * \brief Store the RTT metrics of the connection in the cache of the
+   * node, if at least one RTT sample was taken
+   */
+  void StoreMetrics (void);
+
+  /**
+   * \brief (Re)start the retransmission timer
+   *
+   * Restarting the timer on every ACK would remove and insert an event
+   * in the scheduler each time.  Instead, while the scheduled event
+   * fires no later than the new expiry, only the expiry is moved, and
+   * the event re-arms itself for the remaining time when it fires.
+   * With the LazyRetxTimer attribute set to false, the event is
+   * cancelled and scheduled again every time.
+   *
+   * \param delay time to the expiry, from now
+   */
+  void ArmRetxTimer (Time delay);
+
+  /**
+   * \brief The retransmission timer event fired: call ReTxTimeout if the
+   * expiry has been reached, re-arm the event otherwise
+   */
+  void RetxTimerExpired (void);
+
+  /**
+   * \brief Get the time left before the retransmission timer expires
+   * \return the time left, or zero if the timer is not running
+   */
+  Time GetRetxDelayLeft (void) const;
+
   /**
    * \brief Action upon delay ACK timeout, i.e. send an ACK
    */
@@ -1085,6 +1379,86 @@ protected:
    */
   void DoRetransmit (void);
 
+  /**
+   * \brief A segment has been cumulatively or selectively acknowledged
+   *
+   * Feeds the rate sampler and, if enabled, the RACK state.
+   *
+   * \param item the acknowledged segment
+   */
+  void SkbDelivered (TcpTxItem *item);
+
+  /**
+   * \brief RACK time-based loss detection (RFC 8985, Section 6.2)
+   *
+   * The oldest outstanding segment is deemed lost if it was sent before
+   * the most recently delivered segment, and at least RACK.rtt plus the
+   * reordering window ago.  Then recovery is entered or, in recovery, the
+   * lost retransmission of the head is marked as lost, to be sent again
+   * by SendPendingData, and congestion control reacts to it as to a new
+   * congestion event.  If the segment was sent before but its deadline
+   * is still ahead, the reordering timer is armed for it.  Send times are
+   * taken from the RTT history.
+   *
+   * Unlike RFC 8985, only the head is checked, not every segment sent
+   * before RACK.xmit_ts; the segments behind it are left to the SACK
+   * scoreboard.
+   *
+   * \param currentDelivered Currently (S)ACKed bytes
+   */
+  void RackDetectLoss (uint32_t currentDelivered);
+
+  /**
+   * \brief The RACK reordering timer expired, check the head again
+   */
+  void RackTimeout (void);
+
+  /**
+   * \brief (Re)arm the tail loss probe timer (RFC 8985, Section 7.2)
+   *
+   * PTO is 2 * SRTT, plus the delayed ACK timeout if a single segment is
+   * outstanding, and never beyond the pending RTO.
+   */
+  void ArmTlpTimer (void);
+
+  /**
+   * \brief Send a tail loss probe: a new segment if the receiver window
+   * allows it, the last segment sent otherwise
+   */
+  void TlpTimeout (void);
+
+  /**
+   * \brief Check whether the last RTO was spurious, and undo its response
+   *
+   * With timestamps, the Eifel detection algorithm (RFC 3522) compares
+   * the timestamp echoed by the first ACK advancing SND.UNA with the one
+   * of the RTO retransmission.  Without, F-RTO (RFC 5682, Section 2.1)
+   * sends new data on the first such ACK, and declares the RTO spurious
+   * if the next ACK advances SND.UNA as well.
+   *
+   * While the check is pending only the head is marked as lost, so that
+   * nothing but the head is retransmitted; otherwise the whole window is
+   * marked lost once the RTO proves genuine (RFC 4015, Section 3).
+   *
+   * \param tcpHeader the header of the ACK
+   * \param ackNumber the ACK number
+   * \param oldHeadSequence SND.UNA before the ACK
+   */
+  void DetectSpuriousRto (const TcpHeader& tcpHeader, const SequenceNumber32 &ackNumber,
+                          const SequenceNumber32 &oldHeadSequence);
+
+  /**
+   * \brief Restore cwnd and ssThresh as they were before a spurious RTO,
+   * and go back to CA_OPEN
+   */
+  void UndoSpuriousRto (void);
+
+  /**
+   * \brief The last RTO was not spurious, mark the window lost as a
+   * normal RTO would
+   */
+  void ConfirmRto (void);
+
   /** \brief Add options to TcpHeader
    *
    * Test each option, and if it is enabled on our side, add it
@@ -1244,6 +1618,7 @@ protected:
 protected:
   // Counters and events
   EventId           m_retxEvent     {}; //!< Retransmission event
+  Time              m_retxExpiry    {Seconds (0.0)}; //!< Expiry of the retransmission timer, zero if m_retxEvent is not armed by ArmRetxTimer
   EventId           m_lastAckEvent  {}; //!< Last ACK timeout event
   EventId           m_delAckEvent   {}; //!< Delayed ACK timeout event
   EventId           m_persistEvent  {}; //!< Persist event: Send 1 byte to probe for a non-zero Rx window
@@ -1271,8 +1646,19 @@ protected:
   Time              m_persistTimeout   {Seconds (0.0)};   //!< Time between sending 1-byte probes
   Time              m_cnTimeout        {Seconds (0.0)};   //!< Timeout for connection retry
 
+  // RTO derived from the RTT estimator, and the estimates it was derived from
+  Time              m_rtoCacheEstimate  {Seconds (0.0)}; //!< RTT estimate used for the cached RTO
+  Time              m_rtoCacheVariation {Seconds (0.0)}; //!< RTT variation used for the cached RTO
+  Time              m_rtoCacheUnclamped {Seconds (0.0)}; //!< Cached RTO, without the minimum RTO
+  Time              m_rtoCacheRto       {Seconds (0.0)}; //!< Cached RTO
+  uint32_t          m_rtoCacheVersion   {0};             //!< Version of the RTO policy used for the cached RTO
+  bool              m_rtoCacheValid     {false};         //!< The cached RTO matches the current parameters
+
   // History of RTT
-  std::deque<RttHistory>      m_history;         //!< List of sent packet
+  RttHistoryBuffer            m_history;         //!< List of sent packet
+  uint32_t                    m_historyMaxCount {0}; //!< Upper bound of the count of the entries in m_history
+  bool                        m_perSegmentRtt {false}; //!< Sample the RTT of every acked segment
+  std::vector<Time>           m_rttSamples;      //!< RTT samples taken from one ACK, reused across ACKs
 
   // Connections to other layers of TCP/IP
   Ipv4EndPoint*       m_endPoint  {nullptr}; //!< the IPv4 endpoint
@@ -1283,6 +1669,9 @@ protected:
   Callback<void, Ipv6Address,uint8_t,uint8_t,uint8_t,uint32_t> m_icmpCallback6; //!< ICMPv6 callback
 
   Ptr<RttEstimator> m_rtt; //!< Round trip time estimator
+  Ptr<RtoPolicy>    m_rtoPolicy; //!< Derivation of the RTO from m_rtt
+  MinRttFilter      m_minRttFilter; //!< Windowed minimum of the RTT, exported in m_tcb->m_minRtt
+  bool              m_useMetricsCache {false}; //!< Seed and store the RTT in the per-destination cache
 
   // Tx buffer management
   Ptr<TcpTxBuffer> m_txBuffer; //!< Tx buffer
@@ -1323,6 +1712,35 @@ protected:
                                                   //!< which was set for handling previous congestion event.
   uint32_t               m_retxThresh {3};   //!< Fast Retransmit threshold
   bool                   m_limitedTx  {true}; //!< perform limited transmit
+  bool                   m_lazyRetxTimer {true}; //!< Re-arm the retransmission timer lazily, see ArmRetxTimer
+
+  // RACK-TLP (RFC 8985)
+  bool                   m_rackEnabled {false}; //!< RACK loss detection enabled
+  bool                   m_tlpEnabled  {false}; //!< Tail loss probe enabled
+  Time                   m_rackXmitTs  {Seconds (0.0)}; //!< Send time of the most recently sent delivered segment
+  Time                   m_rackRtt     {Seconds (0.0)}; //!< RTT of the most recently sent delivered segment
+  EventId                m_rackEvent   {}; //!< RACK reordering timer
+  EventId                m_tlpEvent    {}; //!< Tail loss probe timer
+  bool                   m_tlpInFlight {false}; //!< A probe has been sent and not yet answered
+
+  /**
+   * \brief Progress of the detection of a spurious RTO
+   */
+  typedef enum
+  {
+    SPURIOUS_RTO_NONE,       //!< No detection pending
+    SPURIOUS_RTO_EIFEL,      //!< Waiting for the first ACK advancing SND.UNA (RFC 3522)
+    SPURIOUS_RTO_FRTO_FIRST, //!< F-RTO step 2, waiting for the first ACK
+    SPURIOUS_RTO_FRTO_SECOND //!< F-RTO step 3, new data sent, waiting for the second ACK
+  } SpuriousRtoState_t;
+
+  // Spurious RTO detection and response (RFC 3522, RFC 5682, RFC 4015)
+  bool                   m_undoSpuriousRto {false}; //!< Detect and undo spurious RTOs
+  SpuriousRtoState_t     m_spuriousRtoState {SPURIOUS_RTO_NONE}; //!< Detection in progress
+  uint32_t               m_undoCwnd      {0}; //!< cwnd before the RTO
+  uint32_t               m_undoSsThresh  {0}; //!< ssThresh before the RTO
+  uint32_t               m_undoTsVal     {0}; //!< Timestamp of the RTO retransmission
+  TracedValue<uint32_t>  m_undoneRtos    {0}; //!< Number of RTOs undone as spurious
 
   // Transmission Control Block
   Ptr<TcpSocketState>    m_tcb;               //!< Congestion control information